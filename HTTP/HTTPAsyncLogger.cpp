@@ -0,0 +1,350 @@
+/**
+* @file HTTPAsyncLogger.cpp
+* @brief implementation of the asynchronous logger
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPAsyncLogger.h"
+#include "HTTPClient.h"    // log messages formats
+
+#include <chrono>
+#include <cstdio>          // snprintf
+#include <cstring>         // strncpy
+
+namespace
+{
+// copies a string in a record's buffer, a truncated string ends with "..."
+void CopyTruncated(char* pszDest, const size_t usSize, const char* pszSource)
+{
+   std::strncpy(pszDest, pszSource, usSize - 1);
+   pszDest[usSize - 1] = '\0';
+
+   // pszSource has at least usSize - 1 characters when its copy fills the buffer
+   if (std::strlen(pszDest) == usSize - 1 && pszSource[usSize - 1] != '\0')
+      std::memcpy(pszDest + usSize - 4, "...", 3);
+}
+}
+
+/**
+ * @brief constructor of the asynchronous logger
+ *
+ * @param Logger - a callabck to a logger function void(const std::string&), it will only
+ * be called from the logger's background thread
+ * @param usCapacity - number of log records the ring buffer can hold (rounded up to a power of two)
+ *
+ */
+CHTTPAsyncLogger::CHTTPAsyncLogger(LogFnCallback Logger, const size_t usCapacity /* = 4096 */) :
+   m_oLog(Logger),
+   m_usMask(0),
+   m_usEnqueuePos(0),
+   m_usDequeuePos(0),
+   m_ulLogged(0),
+   m_ulDropped(0),
+   m_ulReportedDropped(0),
+   m_bRunning(false),
+   m_usProducers(0),
+   m_uFlushIntervalMs(10),
+   m_bSleeping(false)
+{
+   size_t usSize = 2;
+   while (usSize < usCapacity)
+      usSize <<= 1;
+
+   m_pCells.reset(new Cell[usSize]);
+   m_usMask = usSize - 1;
+
+   for (size_t i = 0; i < usSize; ++i)
+      m_pCells[i].usSequence.store(i, std::memory_order_relaxed);
+}
+
+/**
+ * @brief destructor of the asynchronous logger, the pending records are flushed
+ *
+ */
+CHTTPAsyncLogger::~CHTTPAsyncLogger()
+{
+   if (IsRunning())
+      StopLogger();
+}
+
+/**
+ * @brief starts the background thread formatting and printing the log records
+ *
+ * @param [in] uFlushIntervalMs time the background thread lets the records pile up once
+ * woken up by the first one (it sleeps as long as the buffer is empty)
+ *
+ * @retval true   Successfully started the logger.
+ * @retval false  The logger is already started.
+ */
+const bool CHTTPAsyncLogger::StartLogger(const unsigned uFlushIntervalMs /* = 10 */)
+{
+   if (IsRunning())
+      return false;
+
+   m_uFlushIntervalMs = uFlushIntervalMs;
+   m_bRunning.store(true, std::memory_order_release);
+   m_Consumer = std::thread(&CHTTPAsyncLogger::Consume, this);
+
+   return true;
+}
+
+/**
+ * @brief stops the background thread after it has printed the pending records
+ *
+ * @retval true   Successfully stopped the logger.
+ * @retval false  The logger is not started.
+ */
+const bool CHTTPAsyncLogger::StopLogger()
+{
+   if (!IsRunning())
+      return false;
+
+   // seq_cst : a producer either sees the logger stopped or is waited for (see Push)
+   m_bRunning.store(false, std::memory_order_seq_cst);
+   {
+      std::lock_guard<std::mutex> Lock(m_mtxWakeUp);
+      m_cvWakeUp.notify_one();
+   }
+
+   if (m_Consumer.joinable())
+      m_Consumer.join();
+
+   return true;
+}
+
+/**
+ * @brief writes a log record in the ring buffer, doesn't allocate memory nor wait for the
+ * background thread (only takes its mutex to wake it up when the buffer was empty)
+ *
+ * @param [in] eEvent logged event
+ * @param [in] pszUrl URL of the request (can be null, truncated to 159 bytes)
+ * @param [in] eCode libcurl code
+ * @param [in] lStatus HTTP status code
+ * @param [in] pszLocalFile local file path (can be null, truncated to 79 bytes)
+ *
+ * @retval true   The record was handled : queued or dropped (the buffer is full).
+ * @retval false  The logger is not started, the message must be logged synchronously.
+ */
+const bool CHTTPAsyncLogger::Push(const LogEvent eEvent, const char* pszUrl /* = nullptr */,
+                                  const CURLcode eCode /* = CURLE_OK */, const long lStatus /* = 0 */,
+                                  const char* pszLocalFile /* = nullptr */)
+{
+   // StopLogger waits for the records being pushed
+   m_usProducers.fetch_add(1, std::memory_order_seq_cst);
+   if (!m_bRunning.load(std::memory_order_seq_cst))
+   {
+      m_usProducers.fetch_sub(1, std::memory_order_release);
+      return false;
+   }
+
+   Cell* pCell = nullptr;
+   size_t usPos = m_usEnqueuePos.load(std::memory_order_relaxed);
+   for (;;)
+   {
+      pCell = &m_pCells[usPos & m_usMask];
+      const size_t usSequence = pCell->usSequence.load(std::memory_order_acquire);
+      const intptr_t iDiff = static_cast<intptr_t>(usSequence) - static_cast<intptr_t>(usPos);
+
+      if (iDiff == 0)
+      {
+         if (m_usEnqueuePos.compare_exchange_weak(usPos, usPos + 1, std::memory_order_relaxed))
+            break;
+      }
+      else if (iDiff < 0)
+      {
+         // full
+         m_ulDropped.fetch_add(1, std::memory_order_relaxed);
+         m_usProducers.fetch_sub(1, std::memory_order_release);
+         return true;
+      }
+      else
+         usPos = m_usEnqueuePos.load(std::memory_order_relaxed);
+   }
+
+   LogRecord& Record = pCell->Record;
+   Record.eEvent = static_cast<uint16_t>(eEvent);
+   Record.eCode = static_cast<int32_t>(eCode);
+   Record.lStatus = lStatus;
+
+   Record.szUrl[0] = '\0';
+   if (pszUrl != nullptr)
+      CopyTruncated(Record.szUrl, URL_SIZE, pszUrl);
+
+   Record.szLocalFile[0] = '\0';
+   if (pszLocalFile != nullptr)
+      CopyTruncated(Record.szLocalFile, LOCAL_FILE_SIZE, pszLocalFile);
+
+   pCell->usSequence.store(usPos + 1, std::memory_order_release);
+
+   // the background thread either sees the record or is sleeping (see Consume)
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (m_bSleeping.load(std::memory_order_relaxed))
+   {
+      std::lock_guard<std::mutex> Lock(m_mtxWakeUp);
+      m_cvWakeUp.notify_one();
+   }
+
+   m_usProducers.fetch_sub(1, std::memory_order_release);
+
+   return true;
+}
+
+/**
+ * @brief returns the level of a log event
+ */
+const CHTTPAsyncLogger::LogLevel CHTTPAsyncLogger::GetEventLevel(const LogEvent eEvent)
+{
+   return (eEvent == EVENT_OBJECT_NOT_CLEANED) ? LEVEL_WARNING : LEVEL_ERROR;
+}
+
+/**
+ * @brief formats the message of a log event
+ *
+ * @param [in] eEvent logged event
+ * @param [in] pszUrl URL of the request
+ * @param [in] eCode libcurl code
+ * @param [in] lStatus HTTP status code
+ * @param [in] pszLocalFile local file path
+ *
+ * @retval string formatted message
+ */
+std::string CHTTPAsyncLogger::FormatLogMessage(const LogEvent eEvent, const char* pszUrl, const CURLcode eCode,
+                                               const long lStatus, const char* pszLocalFile)
+{
+   if (pszUrl == nullptr)
+      pszUrl = "";
+   if (pszLocalFile == nullptr)
+      pszLocalFile = "";
+
+   char szBuffer[512];
+   int iLength = 0;
+
+   switch (eEvent)
+   {
+   case EVENT_EMPTY_HOST:
+      return LOG_ERROR_EMPTY_HOST_MSG;
+   case EVENT_OBJECT_NOT_CLEANED:
+      return LOG_WARNING_OBJECT_NOT_CLEANED;
+   case EVENT_ALREADY_INIT:
+      return LOG_ERROR_CURL_ALREADY_INIT_MSG;
+   case EVENT_NOT_INIT:
+      return LOG_ERROR_CURL_NOT_INIT_MSG;
+
+   case EVENT_REQUEST_FAILURE:
+      iLength = std::snprintf(szBuffer, sizeof(szBuffer), LOG_ERROR_CURL_REQ_FAILURE_FORMAT,
+                              pszUrl, eCode, curl_easy_strerror(eCode), lStatus);
+      break;
+   case EVENT_REST_FAILURE:
+      iLength = std::snprintf(szBuffer, sizeof(szBuffer), LOG_ERROR_CURL_REST_FAILURE_FORMAT,
+                              pszUrl, eCode, curl_easy_strerror(eCode));
+      break;
+   case EVENT_DOWNLOAD_FAILURE:
+      iLength = std::snprintf(szBuffer, sizeof(szBuffer), LOG_ERROR_CURL_DOWNLOAD_FAILURE_FORMAT,
+                              pszLocalFile, pszUrl, eCode, curl_easy_strerror(eCode), lStatus);
+      break;
+   case EVENT_LOCAL_FILE_FAILURE:
+      iLength = std::snprintf(szBuffer, sizeof(szBuffer), LOG_ERROR_DOWNLOAD_FILE_FORMAT, pszLocalFile);
+      break;
+   default:
+      return std::string();
+   }
+
+   if (iLength < 0)
+      return std::string();
+
+   if (static_cast<size_t>(iLength) < sizeof(szBuffer))
+      return std::string(szBuffer, iLength);
+
+   // long URLs : format again in a buffer large enough
+   std::string strMessage(iLength, '\0');
+   switch (eEvent)
+   {
+   case EVENT_REQUEST_FAILURE:
+      std::snprintf(&strMessage[0], iLength + 1, LOG_ERROR_CURL_REQ_FAILURE_FORMAT,
+                    pszUrl, eCode, curl_easy_strerror(eCode), lStatus);
+      break;
+   case EVENT_REST_FAILURE:
+      std::snprintf(&strMessage[0], iLength + 1, LOG_ERROR_CURL_REST_FAILURE_FORMAT,
+                    pszUrl, eCode, curl_easy_strerror(eCode));
+      break;
+   case EVENT_DOWNLOAD_FAILURE:
+      std::snprintf(&strMessage[0], iLength + 1, LOG_ERROR_CURL_DOWNLOAD_FAILURE_FORMAT,
+                    pszLocalFile, pszUrl, eCode, curl_easy_strerror(eCode), lStatus);
+      break;
+   default:
+      std::snprintf(&strMessage[0], iLength + 1, LOG_ERROR_DOWNLOAD_FILE_FORMAT, pszLocalFile);
+      break;
+   }
+
+   return strMessage;
+}
+
+/**
+ * @brief formats and prints all the records available in the ring buffer (consumer side)
+ */
+void CHTTPAsyncLogger::Drain()
+{
+   for (;;)
+   {
+      Cell* pCell = &m_pCells[m_usDequeuePos & m_usMask];
+      const size_t usSequence = pCell->usSequence.load(std::memory_order_acquire);
+
+      if (usSequence != m_usDequeuePos + 1)
+         break; // empty
+
+      const LogRecord& Record = pCell->Record;
+      std::string strMessage = FormatLogMessage(static_cast<LogEvent>(Record.eEvent), Record.szUrl,
+                                                static_cast<CURLcode>(Record.eCode), Record.lStatus,
+                                                Record.szLocalFile);
+
+      // the cell can be reused by producers
+      pCell->usSequence.store(m_usDequeuePos + m_usMask + 1, std::memory_order_release);
+      ++m_usDequeuePos;
+
+      m_ulLogged.fetch_add(1, std::memory_order_relaxed);
+      if (m_oLog)
+         m_oLog(strMessage);
+   }
+
+   const uint64_t ulDropped = m_ulDropped.load(std::memory_order_relaxed);
+   if (ulDropped != m_ulReportedDropped)
+   {
+      char szBuffer[128];
+      std::snprintf(szBuffer, sizeof(szBuffer), LOG_WARNING_LOG_RECORDS_DROPPED_FORMAT,
+                    static_cast<unsigned long long>(ulDropped - m_ulReportedDropped));
+      m_ulReportedDropped = ulDropped;
+
+      if (m_oLog)
+         m_oLog(szBuffer);
+   }
+}
+
+/**
+ * @brief background thread body
+ */
+void CHTTPAsyncLogger::Consume()
+{
+   std::unique_lock<std::mutex> Lock(m_mtxWakeUp);
+   while (IsRunning())
+   {
+      Lock.unlock();
+      Drain();
+      Lock.lock();
+
+      // sleeps until a record is pushed
+      m_bSleeping.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      m_cvWakeUp.wait(Lock, [this]() { return !IsRunning() || !IsEmpty(); });
+      m_bSleeping.store(false, std::memory_order_relaxed);
+
+      // and lets the following ones pile up
+      if (m_uFlushIntervalMs > 0)
+         m_cvWakeUp.wait_for(Lock, std::chrono::milliseconds(m_uFlushIntervalMs), [this]() { return !IsRunning(); });
+   }
+   Lock.unlock();
+
+   // records pushed while the logger was stopping
+   while (m_usProducers.load(std::memory_order_seq_cst) != 0)
+      std::this_thread::yield();
+   Drain();
+}
@@ -0,0 +1,141 @@
+/*
+ * @file HTTPAsyncLogger.h
+ * @brief asynchronous logger taking log messages formatting off the request path
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPASYNCLOGGER_H_
+#define INCLUDE_HTTPASYNCLOGGER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>         // std::size_t
+#include <cstdint>
+#include <curl/curl.h>
+#include <functional>
+#include <memory>          // std::unique_ptr
+#include <mutex>
+#include <string>
+#include <thread>
+
+/* Clients using this logger (see CHTTPClient::SetAsyncLogger) don't format their log
+ * messages nor call the log callback anymore : they write a small binary record (event,
+ * CURLcode, HTTP status, URL, local file) in a lock-free ring buffer. The record has a fixed
+ * size : the URLs longer than 159 bytes and the local paths longer than 79 bytes are
+ * truncated and end with "..." (the synchronous messages show them in full). A background thread drains the
+ * buffer, formats the messages and calls the log callback, which is thus always called
+ * from the same thread. It sleeps while the buffer is empty and is woken up by the first
+ * record pushed. When the buffer is full, records are dropped and counted.
+ *
+ * The logger must outlive the clients using it. */
+class CHTTPAsyncLogger
+{
+public:
+   // Public definitions
+   typedef std::function<void(const std::string&)> LogFnCallback;
+
+   enum LogLevel
+   {
+      LEVEL_ERROR,
+      LEVEL_WARNING
+   };
+
+   enum LogEvent
+   {
+      EVENT_EMPTY_HOST,
+      EVENT_OBJECT_NOT_CLEANED,
+      EVENT_ALREADY_INIT,
+      EVENT_NOT_INIT,
+      EVENT_REQUEST_FAILURE,     // URL, CURLcode, HTTP status
+      EVENT_REST_FAILURE,        // URL, CURLcode
+      EVENT_DOWNLOAD_FAILURE,    // URL, CURLcode, HTTP status, local file
+      EVENT_LOCAL_FILE_FAILURE   // local file
+   };
+
+   /* usCapacity is rounded up to a power of two */
+   explicit CHTTPAsyncLogger(LogFnCallback oLogger, const size_t usCapacity = 4096);
+   virtual ~CHTTPAsyncLogger();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPAsyncLogger(const CHTTPAsyncLogger& Copy) = delete;
+   CHTTPAsyncLogger& operator=(const CHTTPAsyncLogger& Copy) = delete;
+
+   /* Background thread : once woken up, it lets the records pile up for uFlushIntervalMs
+    * before printing them. The records pushed before StopLogger returns are printed. */
+   const bool StartLogger(const unsigned uFlushIntervalMs = 10);
+   const bool StopLogger();
+   inline const bool IsRunning() const { return m_bRunning.load(std::memory_order_acquire); }
+
+   // Producers (lock-free, can be called from any thread)
+   const bool Push(const LogEvent eEvent, const char* pszUrl = nullptr, const CURLcode eCode = CURLE_OK,
+                   const long lStatus = 0, const char* pszLocalFile = nullptr);
+
+   // Statistics
+   inline const uint64_t GetLoggedCount() const { return m_ulLogged.load(std::memory_order_relaxed); }
+   inline const uint64_t GetDroppedCount() const { return m_ulDropped.load(std::memory_order_relaxed); }
+   inline const size_t GetCapacity() const { return m_usMask + 1; }
+
+   // Formatting (also used by the clients logging synchronously)
+   static const LogLevel GetEventLevel(const LogEvent eEvent);
+   static std::string FormatLogMessage(const LogEvent eEvent, const char* pszUrl, const CURLcode eCode,
+                                       const long lStatus, const char* pszLocalFile);
+
+protected:
+   enum
+   {
+      URL_SIZE = 160,
+      LOCAL_FILE_SIZE = 80
+   };
+
+   // compact log record, the strings are truncated to URL_SIZE - 1 and LOCAL_FILE_SIZE - 1 bytes
+   struct LogRecord
+   {
+      uint16_t eEvent;
+      int32_t  eCode;
+      long     lStatus;
+      char     szUrl[URL_SIZE];
+      char     szLocalFile[LOCAL_FILE_SIZE];
+   };
+
+   // ring buffer cell (bounded MPMC queue from Dmitry Vyukov)
+   struct Cell
+   {
+      std::atomic<size_t> usSequence;
+      LogRecord           Record;
+   };
+
+   void Drain();
+   void Consume();
+   inline const bool IsEmpty() const // consumer thread only
+   {
+      return m_pCells[m_usDequeuePos & m_usMask].usSequence.load(std::memory_order_acquire) != m_usDequeuePos + 1;
+   }
+
+   LogFnCallback            m_oLog;
+   std::unique_ptr<Cell[]>  m_pCells;
+   size_t                   m_usMask;
+
+   alignas(64) std::atomic<size_t> m_usEnqueuePos;
+   alignas(64) size_t              m_usDequeuePos; // consumer thread only
+
+   std::atomic<uint64_t>    m_ulLogged;
+   std::atomic<uint64_t>    m_ulDropped;
+   uint64_t                 m_ulReportedDropped; // consumer thread only
+
+   std::atomic<bool>        m_bRunning;
+   std::atomic<size_t>      m_usProducers;       // Push calls in progress
+   unsigned                 m_uFlushIntervalMs;
+   std::thread              m_Consumer;
+
+   // wakes the background thread up when the buffer is no longer empty, or to stop it
+   std::mutex               m_mtxWakeUp;
+   std::condition_variable  m_cvWakeUp;
+   std::atomic<bool>        m_bSleeping;
+};
+
+// Logs messages
+#define LOG_WARNING_LOG_RECORDS_DROPPED_FORMAT  "[HTTPClient][Warning] Asynchronous logger is full, " \
+                                                "%llu log message(s) dropped."
+
+#endif
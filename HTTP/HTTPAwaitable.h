@@ -0,0 +1,117 @@
+/*
+ * @file HTTPAwaitable.h
+ * @brief C++20 coroutine interface for REST requests (optional, header only)
+ *
+ * This header requires a C++20 compiler and is never included by the library
+ * itself, so the rest of the API can still be used from C++14 code.
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPAWAITABLE_H_
+#define INCLUDE_HTTPAWAITABLE_H_
+
+#if !defined(__cpp_impl_coroutine) || (__cplusplus < 202002L && !defined(_MSVC_LANG))
+#error "HTTPAwaitable.h requires a C++20 compiler with coroutines support"
+#endif
+
+#include <coroutine>
+#include <string>
+#include <utility>   // std::move
+
+#include "HTTPTransferEngine.h"
+
+/* Exposes the REST requests as awaitable objects :
+ *
+ *    CHTTPClient::HttpResponse Response = co_await AwaitClient.GetAwait(strUrl, Headers);
+ *
+ * The awaiting coroutine is suspended until the request is done and is resumed
+ * from CHTTPTransferEngine::Run(), on the thread running the engine. On failure,
+ * the response code is set to -1, as with the blocking REST methods. */
+class CHTTPAwaitClient
+{
+public:
+   class RestAwaitable
+   {
+   public:
+      RestAwaitable(CHTTPTransferEngine& Engine, const CHTTPTransferEngine::RestMethod eMethod,
+                    std::string strUrl, CHTTPClient::HeadersMap Headers, std::string strBody) :
+         m_Engine(Engine),
+         m_eMethod(eMethod),
+         m_strUrl(std::move(strUrl)),
+         m_Headers(std::move(Headers)),
+         m_strBody(std::move(strBody))
+      {
+      }
+
+      bool await_ready() const noexcept { return false; }
+
+      // returns false (i.e. resumes immediately) if the request couldn't be submitted
+      bool await_suspend(std::coroutine_handle<> hCoroutine)
+      {
+         const bool bSubmitted = m_Engine.Submit(m_eMethod, m_strUrl, m_Headers, std::move(m_strBody),
+            [this, hCoroutine](const bool, CHTTPClient::HttpResponse& Response)
+            {
+               m_Response = std::move(Response);
+               hCoroutine.resume();
+            });
+
+         if (!bSubmitted)
+            m_Response.iCode = -1;
+
+         return bSubmitted;
+      }
+
+      CHTTPClient::HttpResponse await_resume() { return std::move(m_Response); }
+
+   private:
+      CHTTPTransferEngine&              m_Engine;
+      CHTTPTransferEngine::RestMethod   m_eMethod;
+      std::string                       m_strUrl;
+      CHTTPClient::HeadersMap           m_Headers;
+      std::string                       m_strBody;
+      CHTTPClient::HttpResponse         m_Response;
+   };
+
+   explicit CHTTPAwaitClient(CHTTPTransferEngine& Engine) : m_Engine(Engine) {}
+
+   // REST requests
+   RestAwaitable HeadAwait(std::string strUrl, CHTTPClient::HeadersMap Headers)
+   {
+      return RestAwaitable(m_Engine, CHTTPTransferEngine::REST_HEAD, std::move(strUrl), std::move(Headers), {});
+   }
+   RestAwaitable GetAwait(std::string strUrl, CHTTPClient::HeadersMap Headers)
+   {
+      return RestAwaitable(m_Engine, CHTTPTransferEngine::REST_GET, std::move(strUrl), std::move(Headers), {});
+   }
+   RestAwaitable DelAwait(std::string strUrl, CHTTPClient::HeadersMap Headers)
+   {
+      return RestAwaitable(m_Engine, CHTTPTransferEngine::REST_DELETE, std::move(strUrl), std::move(Headers), {});
+   }
+   RestAwaitable PostAwait(std::string strUrl, CHTTPClient::HeadersMap Headers, std::string strPostData)
+   {
+      return RestAwaitable(m_Engine, CHTTPTransferEngine::REST_POST, std::move(strUrl), std::move(Headers),
+                           std::move(strPostData));
+   }
+   RestAwaitable PutAwait(std::string strUrl, CHTTPClient::HeadersMap Headers, std::string strPutData)
+   {
+      return RestAwaitable(m_Engine, CHTTPTransferEngine::REST_PUT, std::move(strUrl), std::move(Headers),
+                           std::move(strPutData));
+   }
+   RestAwaitable PatchAwait(std::string strUrl, CHTTPClient::HeadersMap Headers, std::string strPatchData)
+   {
+      return RestAwaitable(m_Engine, CHTTPTransferEngine::REST_PATCH, std::move(strUrl), std::move(Headers),
+                           std::move(strPatchData));
+   }
+   RestAwaitable OptionsAwait(std::string strUrl, CHTTPClient::HeadersMap Headers)
+   {
+      return RestAwaitable(m_Engine, CHTTPTransferEngine::REST_OPTIONS, std::move(strUrl), std::move(Headers), {});
+   }
+
+   inline CHTTPTransferEngine& GetEngine() const { return m_Engine; }
+
+private:
+   CHTTPTransferEngine& m_Engine;
+};
+
+#endif
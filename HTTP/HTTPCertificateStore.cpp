@@ -0,0 +1,147 @@
+/**
+* @file HTTPCertificateStore.cpp
+* @brief implementation of the in-memory certificate store
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPCertificateStore.h"
+
+#include <fstream>
+#include <iterator>
+
+/**
+ * @brief constructor of the store, it holds no certificate
+ */
+CHTTPCertificateStore::CHTTPCertificateStore() :
+   m_pCertificates(std::make_shared<const Certificates>())
+{
+}
+
+/**
+ * @brief destructor of the store
+ */
+CHTTPCertificateStore::~CHTTPCertificateStore()
+{
+}
+
+/**
+ * @brief loads the CA bundle used to verify the servers, the client certificate is kept
+ *
+ * @param [in] strFilePath path of the PEM bundle (e.g. cacert.pem), empty to remove it
+ *
+ * @retval true   The bundle is used by the next requests.
+ * @retval false  The file couldn't be read (or is empty), the previous bundle is kept.
+ */
+const bool CHTTPCertificateStore::LoadCABundle(const std::string& strFilePath)
+{
+   std::lock_guard<std::mutex> Lock(m_mtxLoad);
+
+   const std::shared_ptr<const Certificates> pCurrent = GetCertificates();
+   return Publish(strFilePath, m_strCertPath, m_strKeyPath, pCurrent->strKeyPassword, pCurrent->strType);
+}
+
+/**
+ * @brief loads the certificate (and its key) presented to the servers, the CA bundle is kept
+ *
+ * @param [in] strCertPath path of the certificate, empty to remove it
+ * @param [in] strKeyPath path of the private key, empty if it is in the certificate's file
+ * @param [in] strKeyPassword pass phrase of the private key
+ * @param [in] strType format of the files : "PEM", "DER" or "P12"
+ *
+ * @retval true   The certificate is used by the next requests.
+ * @retval false  A file couldn't be read (or is empty), the previous certificate is kept.
+ */
+const bool CHTTPCertificateStore::LoadClientCertificate(const std::string& strCertPath,
+   const std::string& strKeyPath /* = std::string() */, const std::string& strKeyPassword /* = std::string() */,
+   const std::string& strType /* = "PEM" */)
+{
+   std::lock_guard<std::mutex> Lock(m_mtxLoad);
+
+   return Publish(m_strCAPath, strCertPath, strKeyPath, strKeyPassword, strType);
+}
+
+/**
+ * @brief reads the files of the store again (e.g. after their rotation)
+ *
+ * @retval true   The new certificates are used by the next requests.
+ * @retval false  A file couldn't be read, the previous certificates are kept.
+ */
+const bool CHTTPCertificateStore::Reload()
+{
+   std::lock_guard<std::mutex> Lock(m_mtxLoad);
+
+   const std::shared_ptr<const Certificates> pCurrent = GetCertificates();
+   return Publish(m_strCAPath, m_strCertPath, m_strKeyPath, pCurrent->strKeyPassword, pCurrent->strType);
+}
+
+/**
+ * @brief returns the current snapshot of the certificates, which remains valid as long
+ * as it is referenced
+ */
+std::shared_ptr<const CHTTPCertificateStore::Certificates> CHTTPCertificateStore::GetCertificates() const
+{
+   std::lock_guard<std::mutex> Lock(m_mtxCertificates);
+   return m_pCertificates;
+}
+
+/**
+ * @brief returns the generation of the current snapshot (0 : nothing loaded yet)
+ */
+const uint64_t CHTTPCertificateStore::GetGeneration() const
+{
+   return GetCertificates()->ulGeneration;
+}
+
+/**
+ * @brief reads a whole file in memory
+ *
+ * @param [in] strFilePath path of the file
+ * @param [out] strContent content of the file
+ *
+ * @retval true   The file was read and isn't empty.
+ * @retval false  The file couldn't be read or is empty.
+ */
+const bool CHTTPCertificateStore::ReadFile(const std::string& strFilePath, std::string& strContent)
+{
+   std::ifstream File(strFilePath, std::ios::in | std::ios::binary);
+   if (!File)
+      return false;
+
+   strContent.assign(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+   return !File.bad() && !strContent.empty();
+}
+
+/**
+ * @brief reads the files and replaces the snapshot if they were all read
+ * m_mtxLoad must be locked
+ */
+const bool CHTTPCertificateStore::Publish(const std::string& strCAPath, const std::string& strCertPath,
+   const std::string& strKeyPath, const std::string& strKeyPassword, const std::string& strType)
+{
+   std::shared_ptr<Certificates> pNew = std::make_shared<Certificates>();
+
+   if (!strCAPath.empty() && !ReadFile(strCAPath, pNew->strCABundle))
+      return false;
+
+   if (!strCertPath.empty())
+   {
+      if (!ReadFile(strCertPath, pNew->strCertificate))
+         return false;
+
+      if (!strKeyPath.empty() && !ReadFile(strKeyPath, pNew->strKey))
+         return false;
+
+      pNew->strKeyPassword = strKeyPassword;
+      pNew->strType = strType;
+   }
+
+   m_strCAPath = strCAPath;
+   m_strCertPath = strCertPath;
+   m_strKeyPath = (strCertPath.empty()) ? std::string() : strKeyPath;
+
+   std::lock_guard<std::mutex> Lock(m_mtxCertificates);
+   pNew->ulGeneration = m_pCertificates->ulGeneration + 1;
+   m_pCertificates = std::move(pNew);
+
+   return true;
+}
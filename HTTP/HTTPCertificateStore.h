@@ -0,0 +1,73 @@
+/*
+ * @file HTTPCertificateStore.h
+ * @brief CA bundle and client certificate loaded once in memory and shared by the sessions
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPCERTIFICATESTORE_H_
+#define INCLUDE_HTTPCERTIFICATESTORE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/* Holds the CA bundle and the client certificate and key in memory, so the sessions
+ * attached to it (see CHTTPClient::SetCertificateStore) hand them over to libcurl as blobs
+ * (CURLOPT_CAINFO_BLOB, CURLOPT_SSLCERT_BLOB, CURLOPT_SSLKEY_BLOB) instead of having the
+ * files read again for each handle.
+ *
+ * The certificates are kept in an immutable snapshot : Reload() (e.g. after a rotation of
+ * the files) builds a new snapshot, the transfers in progress keep the previous one and
+ * the next requests of all the sessions use the new one. A failed reload keeps the
+ * previous snapshot. The class is thread-safe, it must outlive the sessions using it. */
+class CHTTPCertificateStore
+{
+public:
+   struct Certificates
+   {
+      Certificates() : ulGeneration(0) {}
+      std::string strCABundle;       // PEM bundle, empty : CHTTPClient::SetCertificateFile
+      std::string strCertificate;    // empty : CHTTPClient::SetSSLCertFile
+      std::string strKey;            // empty : in the certificate blob (or SetSSLKeyFile)
+      std::string strKeyPassword;
+      std::string strType;           // of the certificate and the key ("PEM", "DER", "P12")
+      uint64_t    ulGeneration;      // incremented by each (re)load
+   };
+
+   CHTTPCertificateStore();
+   virtual ~CHTTPCertificateStore();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPCertificateStore(const CHTTPCertificateStore& Copy) = delete;
+   CHTTPCertificateStore& operator=(const CHTTPCertificateStore& Copy) = delete;
+
+   const bool LoadCABundle(const std::string& strFilePath);
+   const bool LoadClientCertificate(const std::string& strCertPath, const std::string& strKeyPath = std::string(),
+                                    const std::string& strKeyPassword = std::string(),
+                                    const std::string& strType = "PEM");
+   const bool Reload();
+
+   std::shared_ptr<const Certificates> GetCertificates() const;
+   const uint64_t GetGeneration() const;
+
+   // Helpers
+   static const bool ReadFile(const std::string& strFilePath, std::string& strContent);
+
+protected:
+   const bool Publish(const std::string& strCAPath, const std::string& strCertPath,
+                      const std::string& strKeyPath, const std::string& strKeyPassword,
+                      const std::string& strType);
+
+   // files of the current snapshot, read again by Reload
+   std::string                         m_strCAPath;
+   std::string                         m_strCertPath;
+   std::string                         m_strKeyPath;
+
+   std::shared_ptr<const Certificates> m_pCertificates;
+   mutable std::mutex                  m_mtxCertificates;
+   std::mutex                          m_mtxLoad;           // serializes the (re)loads
+};
+
+#endif
@@ -7,7 +7,16 @@
 #include "HTTPClient.h"
 
 // Static members initialization
-std::string    CHTTPClient::s_strCertificationAuthorityFile;
+std::shared_ptr<const std::string> CHTTPClient::s_pCertificationAuthorityFile;
+std::atomic<uint64_t> CHTTPClient::s_ulCertificationAuthorityGeneration(0);
+
+// definitions of the producer's return codes (required before C++17)
+constexpr size_t CHTTPClient::PRODUCER_PAUSE;
+constexpr size_t CHTTPClient::PRODUCER_ABORT;
+constexpr long CHTTPClient::DEFAULT_RECEIVE_BUFFER;
+constexpr long CHTTPClient::DEFAULT_UPLOAD_BUFFER;
+constexpr long CHTTPClient::MAX_ADAPTIVE_RECEIVE_BUFFER;
+constexpr long CHTTPClient::MAX_ADAPTIVE_UPLOAD_BUFFER;
 
 #ifdef DEBUG_CURL
 std::string CHTTPClient::s_strCurlTraceLogDirectory;
@@ -20,14 +29,38 @@ std::string CHTTPClient::s_strCurlTraceLogDirectory;
  *
  */
 CHTTPClient::CHTTPClient(LogFnCallback Logger) :
-   m_oLog(Logger),
-   m_iCurlTimeout(0),
-   m_bHTTPS(false),
+   m_bTunnelHttp(true),
+   m_bTunnelHttps(true),
+   m_bAbstractUnixSocket(false),
    m_bNoSignal(false),
-   m_bProgressCallbackSet(false),
+   m_bFastOpen(false),
+   m_bHTTPS(false),
    m_eSettingsFlags(ALL_FLAGS),
-   m_pCurlSession(nullptr),
    m_pHeaderlist(nullptr),
+   m_pRestHeaders(nullptr),
+   m_pPausableMulti(nullptr),
+   m_bPausableTransfer(false),
+   m_bResumeTransfer(false),
+   m_pConnectionPool(nullptr),
+   m_bFileTransfer(false),
+   m_lReceiveBuffer(0),
+   m_lUploadBuffer(0),
+   m_bAdaptiveBuffers(false),
+   m_pProxyPool(nullptr),
+   m_usProxy(CHTTPProxyPool::NO_PROXY),
+   m_pLocalAddressPool(nullptr),
+   m_usLocalAddress(CHTTPLocalAddressPool::NO_ADDRESS),
+   m_pTlsSessionCache(nullptr),
+   m_pDnsCache(nullptr),
+   m_llResolveTimeUs(0),
+   m_ulPreparedId(0),
+   m_ulCertificationAuthorityGeneration(0),
+   m_pCertificateStore(nullptr),
+   m_pCurlSession(nullptr),
+   m_iCurlTimeout(0),
+   m_bProgressCallbackSet(false),
+   m_oLog(Logger),
+   m_pAsyncLogger(nullptr),
    m_curlHandle(CurlHandle::instance())
 {
 
@@ -42,7 +75,7 @@ CHTTPClient::~CHTTPClient()
    if (m_pCurlSession != nullptr)
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_WARNING_OBJECT_NOT_CLEANED);
+         Log(CHTTPAsyncLogger::EVENT_OBJECT_NOT_CLEANED);
 
       CleanupSession();
    }
@@ -71,11 +104,15 @@ const bool CHTTPClient::InitSession(const bool& bHTTPS /* = false */,
    if (m_pCurlSession)
    {
       if (eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_CURL_ALREADY_INIT_MSG);
+         Log(CHTTPAsyncLogger::EVENT_ALREADY_INIT);
 
       return false;
    }
    m_pCurlSession = curl_easy_init();
+   m_ulPreparedId = 0;
+
+   if (m_pCurlSession && m_pConnectionPool)
+      curl_easy_setopt(m_pCurlSession, CURLOPT_SHARE, m_pConnectionPool->GetShare());
 
    m_bHTTPS = bHTTPS;
    m_eSettingsFlags = eSettingsFlags;
@@ -101,7 +138,7 @@ const bool CHTTPClient::CleanupSession()
    if (!m_pCurlSession)
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_CURL_NOT_INIT_MSG);
+         Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
 
       return false;
    }
@@ -121,6 +158,14 @@ const bool CHTTPClient::CleanupSession()
       curl_slist_free_all(m_pHeaderlist);
       m_pHeaderlist = nullptr;
    }
+   m_pRestHeaders = nullptr;
+   m_ulPreparedId = 0;
+
+   if (m_pPausableMulti)
+   {
+      curl_multi_cleanup(m_pPausableMulti);
+      m_pPausableMulti = nullptr;
+   }
 
    return true;
 }
@@ -139,6 +184,7 @@ const bool CHTTPClient::CleanupSession()
    m_ProgressStruct.pCurl = m_pCurlSession;
    m_ProgressStruct.dLastRunTime = 0;
    m_bProgressCallbackSet = true;
+   m_ulPreparedId = 0;
 }
 
 /**
@@ -152,13 +198,13 @@ const bool CHTTPClient::CleanupSession()
    if (strProxy.empty())
       return;
 
-   std::string strUri = strProxy;
-   std::transform(strUri.begin(), strUri.end(), strUri.begin(), ::toupper);
+   m_ulPreparedId = 0;
 
-   if (strUri.compare(0, 4, "HTTP") != 0)
-      m_strProxy = "http://" + strProxy;
+   // no copy : scheme detected in place and m_strProxy's buffer is reused
+   if (!CHTTPUrlBuilder::StartsWithNoCase(strProxy, "HTTP"))
+      m_strProxy.assign("http://").append(strProxy);
    else
-      m_strProxy = strProxy;
+      m_strProxy.assign(strProxy);
 };
 
 /**
@@ -172,20 +218,27 @@ const bool CHTTPClient::CleanupSession()
  */
 inline void CHTTPClient::UpdateURL(const std::string& strURL)
 {
-   std::string strTmp = strURL;
-
-   std::transform(strTmp.begin(), strTmp.end(), strTmp.begin(), ::toupper);
-
-   if (strTmp.compare(0, 7, "HTTP://") == 0)
+   // no copy : scheme detected in place and m_strURL's buffer is reused
+   if (CHTTPUrlBuilder::StartsWithNoCase(strURL, "http://"))
       m_bHTTPS = false;
-   else if (strTmp.compare(0, 8, "HTTPS://") == 0)
+   else if (CHTTPUrlBuilder::StartsWithNoCase(strURL, "https://"))
       m_bHTTPS = true;
    else
    {
-      m_strURL = ((m_bHTTPS) ? "https://" : "http://") + strURL;
+      m_strURL.assign((m_bHTTPS) ? "https://" : "http://").append(strURL);
       return;
    }
-   m_strURL = strURL;
+   m_strURL.assign(strURL);
+}
+
+/**
+ * @brief resets the options of the handle, it is no longer configured for a prepared
+ * request : every reset of the handle goes through here
+ */
+inline void CHTTPClient::ResetSession()
+{
+   m_ulPreparedId = 0;
+   curl_easy_reset(m_pCurlSession);
 }
 
 /**
@@ -197,20 +250,150 @@ inline void CHTTPClient::UpdateURL(const std::string& strURL)
 * @retval false  An error occured while CURL was performing the request.
 */
 const CURLcode CHTTPClient::Perform()
+{
+   CURLcode res = PrepareTransfer();
+   if (res != CURLE_OK)
+      return res;
+
+   // Perform the requested operation
+   res = (m_bPausableTransfer) ? PerformPausable() : curl_easy_perform(m_pCurlSession);
+   res = FailOver(res);
+
+   FinishTransfer(res);
+
+   return res;
+}
+
+/**
+* @brief sends a request that couldn't reach its proxy again through the other proxies of
+* the pool, each of them at most once. Nothing was sent to the server nor received from it,
+* so the request is performed again as is.
+*
+* @param [in] eResult result of the transfer
+*
+* @return result of the last transfer
+*/
+const CURLcode CHTTPClient::FailOver(CURLcode eResult)
+{
+   for (size_t usAttempt = 1; m_pProxyPool && usAttempt < m_pProxyPool->GetSize()
+        && CHTTPProxyPool::IsProxyFailure(m_pCurlSession, eResult); ++usAttempt)
+   {
+      // any kind of transfer (REST, file, form) : the failure of the last attempt is
+      // reported by the caller
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_REQUEST_FAILURE, m_strURL.c_str(), eResult);
+
+      m_pProxyPool->Release(m_usProxy, m_pCurlSession, eResult);
+      m_usProxy = m_pProxyPool->Acquire(m_pCurlSession);
+
+      eResult = (m_bPausableTransfer) ? PerformPausable() : curl_easy_perform(m_pCurlSession);
+   }
+
+   return eResult;
+}
+
+/**
+* @brief performs the prepared handle on the client's multi handle, instead of
+* curl_easy_perform, so a paused transfer is resumed as soon as ResumeTransfer() is called :
+* curl_easy_perform would only notice it on its next internal poll (up to a second later)
+*
+* @return result of the transfer
+*/
+const CURLcode CHTTPClient::PerformPausable()
+{
+   if (!m_pPausableMulti)
+   {
+      m_pPausableMulti = curl_multi_init();
+      if (!m_pPausableMulti)
+         return CURLE_OUT_OF_MEMORY;
+   }
+
+   if (curl_multi_add_handle(m_pPausableMulti, m_pCurlSession) != CURLM_OK)
+      return CURLE_FAILED_INIT;
+
+   CURLcode res = CURLE_OK;
+   int iRunning = 1;
+   while (iRunning > 0)
+   {
+      // curl_easy_pause can't be called from another thread, it is called from here
+      if (m_bResumeTransfer.exchange(false))
+         curl_easy_pause(m_pCurlSession, CURLPAUSE_CONT);
+
+      CURLMcode eCode = curl_multi_perform(m_pPausableMulti, &iRunning);
+      if (eCode == CURLM_OK && iRunning > 0)
+         eCode = curl_multi_poll(m_pPausableMulti, nullptr, 0, 1000, nullptr);
+
+      if (eCode != CURLM_OK)
+      {
+         res = CURLE_FAILED_INIT;
+         break;
+      }
+   }
+
+   CURLMsg* pMsg = nullptr;
+   int iMsgsLeft = 0;
+   while ((pMsg = curl_multi_info_read(m_pPausableMulti, &iMsgsLeft)) != nullptr)
+   {
+      if (pMsg->msg == CURLMSG_DONE)
+         res = pMsg->data.result;
+   }
+
+   curl_multi_remove_handle(m_pPausableMulti, m_pCurlSession);
+
+   return res;
+}
+
+/**
+* @brief resumes a transfer paused by a callback (producer, full response stream),
+* can be called from any thread
+*/
+void CHTTPClient::ResumeTransfer()
+{
+   m_bResumeTransfer = true;
+
+   // the multi handle is created before the first pausable transfer starts
+   if (m_pPausableMulti)
+      curl_multi_wakeup(m_pPausableMulti);
+}
+
+/**
+* @brief sets up the common settings (Timeout, proxy,...) of a request
+* without performing it, so the handle can be either performed right away
+* (see Perform) or driven by a curl multi handle (see CHTTPTransferEngine)
+*
+* @retval CURLE_OK           The handle is ready to be performed.
+* @retval CURLE_FAILED_INIT  The session is not initialized.
+*/
+const CURLcode CHTTPClient::PrepareTransfer()
 {
    if (!m_pCurlSession)
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_CURL_NOT_INIT_MSG);
+         Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
 
       return CURLE_FAILED_INIT;
    }
 
-   CURLcode res = CURLE_OK;
+   // the handle is configured for another request
+   m_ulPreparedId = 0;
 
    curl_easy_setopt(m_pCurlSession, CURLOPT_URL, m_strURL.c_str());
 
-   if (m_pHeaderlist != nullptr)
+   ApplyDnsCache();
+
+   // easy_perform would trim the pool to the handle's default cache size (5)
+   long lMaxConnections = (m_pConnectionPool) ? m_pConnectionPool->GetMaxConnections() : 0;
+
+   // each local address keeps its connections, the rotation mustn't evict them
+   if (m_pLocalAddressPool && m_strUnixSocketPath.empty())
+      lMaxConnections = std::max(lMaxConnections, m_pLocalAddressPool->GetMaxConnections());
+
+   if (lMaxConnections > 0)
+      curl_easy_setopt(m_pCurlSession, CURLOPT_MAXCONNECTS, lMaxConnections);
+
+   if (m_pRestHeaders != nullptr)
+      curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPHEADER, m_pRestHeaders);
+   else if (m_pHeaderlist != nullptr)
       curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPHEADER, m_pHeaderlist);
 
    curl_easy_setopt(m_pCurlSession, CURLOPT_USERAGENT, CLIENT_USERAGENT);
@@ -224,17 +407,36 @@ const CURLcode CHTTPClient::Perform()
       curl_easy_setopt(m_pCurlSession, CURLOPT_NOSIGNAL, 1);
    }
 
-   if (!m_strProxy.empty())
+   if (m_pProxyPool)
    {
-      curl_easy_setopt(m_pCurlSession, CURLOPT_PROXY, m_strProxy.c_str());
-      curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPPROXYTUNNEL, 1L);      
+      // prepared again without being finished (Prewarm)
+      m_pProxyPool->Release(m_usProxy, m_pCurlSession, CURLE_OK);
+      m_usProxy = m_pProxyPool->Acquire(m_pCurlSession);
    }
+   else if (!m_strProxy.empty())
+      curl_easy_setopt(m_pCurlSession, CURLOPT_PROXY, m_strProxy.c_str());
+
+   // ignored with a SOCKS proxy
+   if (m_pProxyPool || !m_strProxy.empty())
+      curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPPROXYTUNNEL, ((m_bHTTPS) ? m_bTunnelHttps : m_bTunnelHttp) ? 1L : 0L);
 
    if (m_bNoSignal)
    {
       curl_easy_setopt(m_pCurlSession, CURLOPT_NOSIGNAL, 1L);
    }
 
+   if (!m_strUnixSocketPath.empty())
+      SetUnixSocket(m_pCurlSession, m_strUnixSocketPath, m_bAbstractUnixSocket);
+   else if (m_pLocalAddressPool)
+      m_usLocalAddress = m_pLocalAddressPool->Acquire(m_pCurlSession);
+
+   const CHTTPSocketProfile* pSocketProfile = (m_bFileTransfer && m_pFileSocketProfile)
+                                              ? m_pFileSocketProfile.get() : m_pSocketProfile.get();
+   if (pSocketProfile)
+      pSocketProfile->Apply(m_pCurlSession);
+
+   ApplyBufferSizes();
+
    if (m_bProgressCallbackSet)
    {
       curl_easy_setopt(m_pCurlSession, CURLOPT_PROGRESSFUNCTION, *GetProgressFnCallback());
@@ -250,25 +452,28 @@ const CURLcode CHTTPClient::Perform()
        curl_easy_setopt(m_pCurlSession, CURLOPT_SSL_VERIFYPEER, (m_eSettingsFlags & CURLOPT_SSL_VERIFYHOST) ? 2L : 0L);
    }
 
-   if (m_bHTTPS && !s_strCertificationAuthorityFile.empty())
-      curl_easy_setopt(m_pCurlSession, CURLOPT_CAINFO, s_strCertificationAuthorityFile.c_str());
-
-   if (m_bHTTPS && !m_strSSLCertFile.empty())
-      curl_easy_setopt(m_pCurlSession, CURLOPT_SSLCERT, m_strSSLCertFile.c_str());
-
-   if (m_bHTTPS && !m_strSSLKeyFile.empty())
-      curl_easy_setopt(m_pCurlSession, CURLOPT_SSLKEY, m_strSSLKeyFile.c_str());
+   ApplyCertificates();
 
-   if (m_bHTTPS && !m_strSSLKeyPwd.empty())
-      curl_easy_setopt(m_pCurlSession, CURLOPT_KEYPASSWD, m_strSSLKeyPwd.c_str());
+   if (m_pTlsSessionCache)
+      m_pTlsSessionCache->Attach(m_pCurlSession);
+   else
+      CHTTPTlsSessionCache::Detach(m_pCurlSession);
 
 #ifdef DEBUG_CURL
    StartCurlDebug();
 #endif
 
-   // Perform the requested operation
-   res = curl_easy_perform(m_pCurlSession);
+   return CURLE_OK;
+}
 
+/**
+* @brief operations to perform once the handle prepared by PrepareTransfer
+* is done (performed or removed from a multi handle)
+*
+* @param [in] eResult result of the transfer
+*/
+void CHTTPClient::FinishTransfer(const CURLcode eResult /* = CURLE_OK */)
+{
 #ifdef DEBUG_CURL
    EndCurlDebug();
 #endif
@@ -278,190 +483,647 @@ const CURLcode CHTTPClient::Perform()
       curl_slist_free_all(m_pHeaderlist);
       m_pHeaderlist = nullptr;
    }
+   m_pRestHeaders = nullptr;
 
-   return res;
+   if (m_pCurlSession)
+   {
+      // the times reported by libcurl are counted from the start of the transfer
+      curl_off_t iNameLookupUs = 0, iConnectUs = 0, iAppConnectUs = 0, iPreTransferUs = 0, iStartTransferUs = 0;
+      curl_easy_getinfo(m_pCurlSession, CURLINFO_NAMELOOKUP_TIME_T, &iNameLookupUs);
+      curl_easy_getinfo(m_pCurlSession, CURLINFO_CONNECT_TIME_T, &iConnectUs);
+      curl_easy_getinfo(m_pCurlSession, CURLINFO_APPCONNECT_TIME_T, &iAppConnectUs);
+      curl_easy_getinfo(m_pCurlSession, CURLINFO_PRETRANSFER_TIME_T, &iPreTransferUs);
+      curl_easy_getinfo(m_pCurlSession, CURLINFO_STARTTRANSFER_TIME_T, &iStartTransferUs);
+
+      if (m_llResolveTimeUs < 0)
+         m_llResolveTimeUs = static_cast<long long>(iNameLookupUs);
+
+      m_ConnectTimings = ConnectTimings();
+      curl_easy_getinfo(m_pCurlSession, CURLINFO_NUM_CONNECTS, &m_ConnectTimings.lNewConnections);
+      m_ConnectTimings.llResolveUs = m_llResolveTimeUs;
+      m_ConnectTimings.llSetupUs = static_cast<long long>(iPreTransferUs);
+      if (iStartTransferUs > iPreTransferUs)
+         m_ConnectTimings.llFirstByteUs = static_cast<long long>(iStartTransferUs - iPreTransferUs);
+      if (m_ConnectTimings.lNewConnections > 0)
+      {
+         if (iConnectUs > iNameLookupUs)
+            m_ConnectTimings.llConnectUs = static_cast<long long>(iConnectUs - iNameLookupUs);
+         if (iAppConnectUs > iConnectUs)
+            m_ConnectTimings.llTlsUs = static_cast<long long>(iAppConnectUs - iConnectUs);
+      }
+
+      if (m_bAdaptiveBuffers)
+         RecordBufferSizes();
+
+      if (m_usProxy != CHTTPProxyPool::NO_PROXY)
+      {
+         if (m_pProxyPool)
+            m_pProxyPool->Release(m_usProxy, m_pCurlSession, eResult);
+         m_usProxy = CHTTPProxyPool::NO_PROXY;
+      }
+
+      if (m_usLocalAddress != CHTTPLocalAddressPool::NO_ADDRESS)
+      {
+         if (m_pLocalAddressPool)
+            m_pLocalAddressPool->Release(m_usLocalAddress, m_pCurlSession, eResult);
+         m_usLocalAddress = CHTTPLocalAddressPool::NO_ADDRESS;
+      }
+   }
 }
 
 /**
- * @brief requests the content of a URI
- *
- * @param [in] strURL URI of the remote location (with the file name) encoded in UTF-8 format.
- * @param [out] strOutput reference to an output string.
- * @param [out] lHTTPStatusCode HTTP Status code of the response.
- *
- * @retval true   Successfully requested the URI.
- * @retval false  Encountered a problem.
+ * @brief attaches the session to a connection pool (or detaches it)
  *
- * Example Usage:
- * @code
- *    std::string strWebPage;
- *    long lHTTPStatusCode = 0;
- *    m_pHTTOClient->GetText("https://www.google.com", strWebPage, lHTTPStatusCode);
- * @endcode
+ * @param [in] pConnectionPool pool shared with other sessions, nullptr to use the
+ * session's own connections
  */
-const bool CHTTPClient::GetText(const std::string& strURL,
-                                std::string& strOutput,
-                                long& lHTTPStatusCode)
+void CHTTPClient::SetConnectionPool(CHTTPConnectionPool* pConnectionPool)
 {
-   if (strURL.empty())
-   {
-      if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_EMPTY_HOST_MSG);
-
-      return false;
-   }
-   if (!m_pCurlSession)
-   {
-      if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_CURL_NOT_INIT_MSG);
-
-      return false;
-   }
-   // Reset is mandatory to avoid bad surprises
-   curl_easy_reset(m_pCurlSession);
-
-   UpdateURL(strURL);
-
-   curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPGET, 1L);
-   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, WriteInStringCallback);
-   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &strOutput);
-
-   CURLcode res = Perform();
-
-   curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHTTPStatusCode);
-
-   // Check for errors
-   if (res != CURLE_OK)
-   {
-      if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(StringFormat(LOG_ERROR_CURL_REQ_FAILURE_FORMAT, m_strURL.c_str(), res,
-                             curl_easy_strerror(res), lHTTPStatusCode));
-
-      return false;
-   }
+   m_pConnectionPool = pConnectionPool;
+   m_ulPreparedId = 0;
 
-   return true;
+   // the share isn't reset by curl_easy_reset : it is set once
+   if (m_pCurlSession)
+      curl_easy_setopt(m_pCurlSession, CURLOPT_SHARE, (pConnectionPool) ? pConnectionPool->GetShare() : nullptr);
 }
 
 /**
- * @brief Downloads a remote file to a local file.
+ * @brief establishes connections in advance and parks them in the session's pool
+ * a HEAD request is sent to each URL on uConnectionsPerHost new connections at once, all
+ * the requests are performed in parallel. A connection counts as warmed when its request
+ * got a response, whatever its status. The requests use the session's settings (TLS,
+ * proxy, timeout, DNS cache...) so the next requests of the pool's sessions can reuse
+ * the connections.
  *
- * @param [in] strLocalFile Complete path of the local file to download in UTF-8 format.
- * @param [in] strURL URI of the remote location (with the file name) encoded in UTF-8 format.
- * @param [out] lHTTPStatusCode HTTP Status code of the response.
+ * @param [in] vecUrls URLs of the hosts to connect to (e.g. "https://api.example.com/")
+ * @param [in] uConnectionsPerHost number of connections to establish to each host
  *
- * @retval true   Successfully downloaded the file.
- * @retval false  The file couldn't be downloaded. Check the log messages for more information.
+ * @return the number of connections requested and warmed (none if the session has no
+ * connection pool)
  */
-const bool CHTTPClient::DownloadFile(const std::string& strLocalFile,
-                                     const std::string& strURL,
-                                     long& lHTTPStatusCode)
+CHTTPConnectionPool::PrewarmReport CHTTPClient::Prewarm(const std::vector<std::string>& vecUrls,
+                                                        const unsigned uConnectionsPerHost)
 {
-   if (strURL.empty() || strLocalFile.empty())
-      return false;
+   CHTTPConnectionPool::PrewarmReport Report;
+   Report.usRequested = vecUrls.size() * uConnectionsPerHost;
+   Report.vecWarmedPerUrl.assign(vecUrls.size(), 0);
 
-   if (!m_pCurlSession)
+   if (!m_pCurlSession || !m_pConnectionPool)
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_CURL_NOT_INIT_MSG);
+         Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
 
-      return false;
+      return Report;
    }
-   // Reset is mandatory to avoid bad surprises
-   curl_easy_reset(m_pCurlSession);
 
-   UpdateURL(strURL);
+   const auto tStart = std::chrono::steady_clock::now();
 
-   std::ofstream ofsOutput;
-   ofsOutput.open(
-#ifdef LINUX
-       strLocalFile, // UTF-8
-#else
-       Utf8ToUtf16(strLocalFile),
-#endif
-       std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+   CURLM* pMulti = curl_multi_init();
+   if (pMulti == nullptr)
+      return Report;
+   curl_multi_setopt(pMulti, CURLMOPT_MAXCONNECTS, m_pConnectionPool->GetMaxConnections());
 
-   if (ofsOutput)
+   // handles duplicated from the session configured for each URL, with their own
+   // CURLOPT_RESOLVE node (the session's one is overwritten by the next URL) and local address
+   std::vector<CURL*> vecHandles;
+   std::vector<size_t> vecHandleAddresses;
+   std::vector<std::string> vecResolveEntries;
+   std::vector<struct curl_slist> vecResolveNodes;
+   vecResolveEntries.reserve(vecUrls.size());
+   vecResolveNodes.reserve(vecUrls.size());
+
+   for (size_t usUrl = 0; usUrl < vecUrls.size(); ++usUrl)
    {
-      curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPGET, 1L);
-      curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, WriteToFileCallback);
-      curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &ofsOutput);
+      ResetSession();
+      UpdateURL(vecUrls[usUrl]);
 
-      CURLcode res = Perform();
+      curl_easy_setopt(m_pCurlSession, CURLOPT_NOBODY, 1L);
+      curl_easy_setopt(m_pCurlSession, CURLOPT_FRESH_CONNECT, 1L);
+      curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, ThrowAwayCallback);
 
-      ofsOutput.close();
-      curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHTTPStatusCode);
+      if (PrepareTransfer() != CURLE_OK)
+         continue;
 
-      //double dUploadLength = 0;
-      //curl_easy_getinfo(m_pCurlSession, CURLINFO_CONTENT_LENGTH_UPLOAD, &dUploadLength); // number of bytes uploaded
-      
-      /* Delete downloaded file if status code != 200 as server's response body may
-      contain error 404 */
-      if (lHTTPStatusCode != 200)
-         remove(strLocalFile.c_str());
+      struct curl_slist* pResolveNode = nullptr;
+      if (m_llResolveTimeUs >= 0)
+      {
+         vecResolveEntries.push_back(m_strResolveEntry);
+         vecResolveNodes.push_back({ &vecResolveEntries.back()[0], nullptr });
+         pResolveNode = &vecResolveNodes.back();
+      }
 
-      if (res != CURLE_OK)
+      for (unsigned uConnection = 0; uConnection < uConnectionsPerHost; ++uConnection)
       {
-         if (m_eSettingsFlags & ENABLE_LOG)
-            m_oLog(StringFormat(LOG_ERROR_CURL_DOWNLOAD_FAILURE_FORMAT, strLocalFile.c_str(),
-               strURL.c_str(), res, curl_easy_strerror(res), lHTTPStatusCode));
+         CURL* pCurl = curl_easy_duphandle(m_pCurlSession);
+         if (pCurl == nullptr)
+            continue;
 
-         return false;
+         curl_easy_setopt(pCurl, CURLOPT_SHARE, m_pConnectionPool->GetShare());
+         curl_easy_setopt(pCurl, CURLOPT_RESOLVE, pResolveNode);
+         curl_easy_setopt(pCurl, CURLOPT_PRIVATE, reinterpret_cast<char*>(usUrl));
+
+         // the requests rotate through the local addresses : so do the warmed connections
+         const size_t usAddress = (m_pLocalAddressPool && m_strUnixSocketPath.empty())
+                                  ? m_pLocalAddressPool->Acquire(pCurl) : CHTTPLocalAddressPool::NO_ADDRESS;
+         curl_multi_add_handle(pMulti, pCurl);
+
+         vecHandles.push_back(pCurl);
+         vecHandleAddresses.push_back(usAddress);
       }
    }
-   else if (m_eSettingsFlags & ENABLE_LOG)
+
+   int iRunning = 0;
+   do
    {
-      m_oLog(StringFormat(LOG_ERROR_DOWNLOAD_FILE_FORMAT, strLocalFile.c_str()));
+      if (curl_multi_perform(pMulti, &iRunning) != CURLM_OK)
+         break;
 
-      return false;
+      int iMessages = 0;
+      while (CURLMsg* pMessage = curl_multi_info_read(pMulti, &iMessages))
+      {
+         if (pMessage->msg != CURLMSG_DONE)
+            continue;
+
+         char* pszPrivate = nullptr;
+         curl_easy_getinfo(pMessage->easy_handle, CURLINFO_PRIVATE, &pszPrivate);
+         const size_t usUrl = reinterpret_cast<size_t>(pszPrivate);
+
+         const size_t usHandle = std::find(vecHandles.begin(), vecHandles.end(), pMessage->easy_handle)
+                                 - vecHandles.begin();
+         if (vecHandleAddresses[usHandle] != CHTTPLocalAddressPool::NO_ADDRESS)
+            m_pLocalAddressPool->Release(vecHandleAddresses[usHandle], pMessage->easy_handle, pMessage->data.result);
+
+         if (pMessage->data.result == CURLE_OK)
+         {
+            ++Report.usWarmed;
+            ++Report.vecWarmedPerUrl[usUrl];
+         }
+         else if (m_eSettingsFlags & ENABLE_LOG)
+            Log(CHTTPAsyncLogger::EVENT_REST_FAILURE, vecUrls[usUrl].c_str(), pMessage->data.result);
+      }
+
+      if (iRunning > 0)
+         curl_multi_poll(pMulti, nullptr, 0, 1000, nullptr);
+   } while (iRunning > 0);
+
+   // the connections stay in the pool
+   for (CURL* pCurl : vecHandles)
+   {
+      curl_multi_remove_handle(pMulti, pCurl);
+      curl_easy_cleanup(pCurl);
    }
+   curl_multi_cleanup(pMulti);
 
-   return true;
+   // the session's handle didn't perform any transfer
+   m_usLocalAddress = CHTTPLocalAddressPool::NO_ADDRESS;
+   FinishTransfer();
+   ResetSession();
+
+   Report.llElapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - tStart).count();
+
+   return Report;
 }
 
 /**
- * @brief downloads a remote file to memory
- *
- * @param [out] data vector of bytes
- * @param [in] strURL URI of the remote location (with the file name) encoded in UTF-8 format.
- * @param [out] lHTTPStatusCode HTTP Status code of the response.
- *
- * @retval true   Successfully downloaded the file.
- * @retval false  The content couldn't be downloaded. Check the log messages for
- * more information.
- */
-const bool CHTTPClient::DownloadFile(std::vector<unsigned char>& data, const std::string& strURL, long& lHTTPStatusCode) {
-	if (strURL.empty())
-		return false;
+* @brief hands the CA bundle and the client certificate over to libcurl : the blobs of the
+* certificate store if one is set, the files otherwise. The blobs aren't copied by libcurl,
+* the snapshot they belong to is kept until the next request.
+*/
+void CHTTPClient::ApplyCertificates()
+{
+   // an empty blob removes the one set for a previous execution of a prepared request
+   static const auto SetBlob = [](CURL* pCurl, const CURLoption eOption, const std::string& strData)
+   {
+      if (strData.empty())
+      {
+         curl_easy_setopt(pCurl, eOption, nullptr);
+         return;
+      }
 
-	if (!m_pCurlSession)
-	{
-		if (m_eSettingsFlags & ENABLE_LOG)
-			m_oLog(LOG_ERROR_CURL_NOT_INIT_MSG);
+      struct curl_blob Blob;
+      Blob.data = const_cast<char*>(strData.data());
+      Blob.len = strData.size();
+      Blob.flags = CURL_BLOB_NOCOPY;
+      curl_easy_setopt(pCurl, eOption, &Blob);
+   };
 
-		return false;
-	}
+   if (m_pCertificateStore)
+      m_pCertificates = m_pCertificateStore->GetCertificates();
+   else
+      m_pCertificates.reset();
 
-	data.clear();
+   const CHTTPCertificateStore::Certificates* pStored = m_pCertificates.get();
 
-	// Reset is mandatory to avoid bad surprises
-	curl_easy_reset(m_pCurlSession);
+   if (pStored)
+   {
+      SetBlob(m_pCurlSession, CURLOPT_CAINFO_BLOB, pStored->strCABundle);
+      SetBlob(m_pCurlSession, CURLOPT_SSLCERT_BLOB, pStored->strCertificate);
+      SetBlob(m_pCurlSession, CURLOPT_SSLKEY_BLOB, pStored->strKey);
+   }
 
-	UpdateURL(strURL);
+   // read before the file : a file set meanwhile is given to the next request
+   m_ulCertificationAuthorityGeneration = s_ulCertificationAuthorityGeneration.load();
 
-	curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPGET, 1L);
+   if (m_bHTTPS && (!pStored || pStored->strCABundle.empty()))
+   {
+      const std::shared_ptr<const std::string> pCAFile = std::atomic_load(&s_pCertificationAuthorityFile);
+      if (pCAFile && !pCAFile->empty())
+         curl_easy_setopt(m_pCurlSession, CURLOPT_CAINFO, pCAFile->c_str());
+   }
+
+   if (pStored && !pStored->strCertificate.empty())
+   {
+      curl_easy_setopt(m_pCurlSession, CURLOPT_SSLCERTTYPE, pStored->strType.c_str());
+      if (!pStored->strKey.empty())
+         curl_easy_setopt(m_pCurlSession, CURLOPT_SSLKEYTYPE, pStored->strType.c_str());
+
+      if (!pStored->strKeyPassword.empty())
+         curl_easy_setopt(m_pCurlSession, CURLOPT_KEYPASSWD, pStored->strKeyPassword.c_str());
+
+      return;
+   }
+
+   if (m_bHTTPS && !m_strSSLCertFile.empty())
+      curl_easy_setopt(m_pCurlSession, CURLOPT_SSLCERT, m_strSSLCertFile.c_str());
+
+   if (m_bHTTPS && !m_strSSLKeyFile.empty())
+      curl_easy_setopt(m_pCurlSession, CURLOPT_SSLKEY, m_strSSLKeyFile.c_str());
+
+   if (m_bHTTPS && !m_strSSLKeyPwd.empty())
+      curl_easy_setopt(m_pCurlSession, CURLOPT_KEYPASSWD, m_strSSLKeyPwd.c_str());
+}
+
+/**
+* @brief connects a handle through a Unix domain socket, the socket's path replaces the
+* host and port of the URL (and of the proxy) to connect to. Both options set the same
+* path : the last one set wins.
+*/
+void CHTTPClient::SetUnixSocket(CURL* pCurl, const std::string& strPath, const bool bAbstract)
+{
+   curl_easy_setopt(pCurl, (bAbstract) ? CURLOPT_ABSTRACT_UNIX_SOCKET : CURLOPT_UNIX_SOCKET_PATH, strPath.c_str());
+}
+
+/**
+* @brief returns true if libcurl reuses the connections opened with TCP Fast Open. libcurl
+* 7.88 doesn't : the peer address of such a connection isn't known when it's registered, no
+* request matches it. 8.14.1 does (the versions in between weren't checked).
+*/
+const bool CHTTPClient::IsFastOpenReusable()
+{
+   static const bool s_bReusable = curl_version_info(CURLVERSION_NOW)->version_num >= 0x080e01;
+   return s_bReusable;
+}
+
+/**
+* @brief lets an idempotent request be sent before the end of the handshakes : in the SYN
+* of a new connection if the server handed a TCP Fast Open cookie over (Linux, macOS), and
+* in the TLS 1.3 early data of a resumed session (libcurl 8.11 and later with OpenSSL or
+* GnuTLS). TCP Fast Open is skipped when it would prevent the connection's reuse.
+*/
+void CHTTPClient::ApplyFastOpen()
+{
+   if (IsFastOpenReusable())
+      curl_easy_setopt(m_pCurlSession, CURLOPT_TCP_FASTOPEN, 1L);
+
+#if LIBCURL_VERSION_NUM >= 0x080b00
+   curl_easy_setopt(m_pCurlSession, CURLOPT_SSL_OPTIONS, static_cast<long>(CURLSSLOPT_EARLYDATA));
+#endif
+}
+
+namespace
+{
+// "scheme://host:port" of an URL, the key of the adaptive buffer sizes
+std::string GetOrigin(const std::string& strUrl)
+{
+   const size_t usScheme = strUrl.find("://");
+   if (usScheme == std::string::npos)
+      return strUrl;
+
+   return strUrl.substr(0, strUrl.find_first_of("/?#", usScheme + 3));
+}
+}
+
+/**
+* @brief sets the sizes of the buffers libcurl receives and sends the bodies with : the
+* sizes set with SetBufferSizes or, with adaptive buffers, the sizes recorded for the host
+* of the request (capped by SetBufferSizes). Without record, the file transfers start with
+* the largest sizes and the other requests with libcurl's defaults.
+*/
+void CHTTPClient::ApplyBufferSizes()
+{
+   long lReceive = m_lReceiveBuffer;
+   long lUpload = m_lUploadBuffer;
+
+   if (m_bAdaptiveBuffers)
+   {
+      const long lMaxReceive = (m_lReceiveBuffer > 0) ? m_lReceiveBuffer : MAX_ADAPTIVE_RECEIVE_BUFFER;
+      const long lMaxUpload = (m_lUploadBuffer > 0) ? m_lUploadBuffer : MAX_ADAPTIVE_UPLOAD_BUFFER;
+
+      const auto itSizes = m_mapBufferSizes.find(GetOrigin(m_strURL));
+      if (itSizes != m_mapBufferSizes.end())
+      {
+         lReceive = std::min(itSizes->second.lReceive, lMaxReceive);
+         lUpload = std::min(itSizes->second.lUpload, lMaxUpload);
+      }
+      else
+      {
+         lReceive = (m_bFileTransfer) ? lMaxReceive : 0;
+         lUpload = (m_bFileTransfer) ? lMaxUpload : 0;
+      }
+   }
+
+   // set each time : the handle isn't reset by all the requests
+   curl_easy_setopt(m_pCurlSession, CURLOPT_BUFFERSIZE, (lReceive > 0) ? lReceive : DEFAULT_RECEIVE_BUFFER);
+   curl_easy_setopt(m_pCurlSession, CURLOPT_UPLOAD_BUFFERSIZE, (lUpload > 0) ? lUpload : DEFAULT_UPLOAD_BUFFER);
+}
+
+/**
+* @brief records the buffer sizes fitting the transfer that just ended for the next
+* transfers to its host. The sizes shrink by half at most per transfer, so a small request
+* doesn't undo what was learned from the large ones.
+*/
+void CHTTPClient::RecordBufferSizes()
+{
+   curl_off_t iReceived = 0, iReceiveSpeed = 0, iSent = 0, iSendSpeed = 0;
+   curl_easy_getinfo(m_pCurlSession, CURLINFO_SIZE_DOWNLOAD_T, &iReceived);
+   curl_easy_getinfo(m_pCurlSession, CURLINFO_SPEED_DOWNLOAD_T, &iReceiveSpeed);
+   curl_easy_getinfo(m_pCurlSession, CURLINFO_SIZE_UPLOAD_T, &iSent);
+   curl_easy_getinfo(m_pCurlSession, CURLINFO_SPEED_UPLOAD_T, &iSendSpeed);
+
+   if (iReceived == 0 && iSent == 0)
+      return;
+
+   const std::string strOrigin = GetOrigin(m_strURL);
+   auto itSizes = m_mapBufferSizes.find(strOrigin);
+   if (itSizes == m_mapBufferSizes.end())
+   {
+      // a session talks to a few hosts, the records of a crawler are dropped
+      if (m_mapBufferSizes.size() >= 64)
+         m_mapBufferSizes.clear();
+
+      itSizes = m_mapBufferSizes.insert({ strOrigin, BufferSizes{ 0, 0 } }).first;
+   }
+
+   BufferSizes& Sizes = itSizes->second;
+   Sizes.lReceive = std::max(AdaptBufferSize(iReceived, iReceiveSpeed, MAX_ADAPTIVE_RECEIVE_BUFFER),
+                             Sizes.lReceive / 2);
+   Sizes.lUpload = std::max(AdaptBufferSize(iSent, iSendSpeed, MAX_ADAPTIVE_UPLOAD_BUFFER),
+                            Sizes.lUpload / 2);
+}
+
+/**
+* @brief returns the buffer size fitting a transfer : a power of two holding what is
+* transferred in about 10 ms at the given throughput, without exceeding the transfer's size
+*
+* @param [in] llBytes size of the transfer
+* @param [in] llBytesPerSec throughput of the transfer
+* @param [in] lMaxSize largest size returned
+*
+* @retval buffer size, between libcurl's default receive buffer size (16 KB) and lMaxSize
+*/
+const long CHTTPClient::AdaptBufferSize(const long long llBytes, const long long llBytesPerSec,
+                                        const long lMaxSize)
+{
+   const long long llTarget = std::min(llBytes, llBytesPerSec / 100);
+
+   long lSize = DEFAULT_RECEIVE_BUFFER;
+   while (lSize < llTarget && lSize < lMaxSize)
+      lSize *= 2;
+
+   return std::min(lSize, lMaxSize);
+}
+
+/**
+ * @brief returns the path of the CA file used by the HTTPS sessions without a certificate
+ * store (empty : libcurl's default bundle)
+ */
+std::string CHTTPClient::GetCertificateFile()
+{
+   const std::shared_ptr<const std::string> pCAFile = std::atomic_load(&s_pCertificationAuthorityFile);
+   return (pCAFile) ? *pCAFile : std::string();
+}
+
+/**
+ * @brief sets the path of the CA file used by the HTTPS sessions without a certificate
+ * store, it can be changed while other threads perform requests
+ *
+ * @param [in] strPath path of the PEM bundle
+ */
+void CHTTPClient::SetCertificateFile(const std::string& strPath)
+{
+   std::atomic_store(&s_pCertificationAuthorityFile, std::make_shared<const std::string>(strPath));
+   ++s_ulCertificationAuthorityGeneration;
+}
+
+/**
+* @brief hands the addresses of the request's host over to libcurl if a DNS cache is set,
+* the cache resolves the host if it doesn't know it yet
+*/
+void CHTTPClient::ApplyDnsCache()
+{
+   m_llResolveTimeUs = -1;
+   if (m_pDnsCache == nullptr || !m_strProxy.empty() || m_pProxyPool || !m_strUnixSocketPath.empty())
+      return;
+
+   const auto tStart = std::chrono::steady_clock::now();
+   if (m_pDnsCache->Lookup(m_strURL, m_strResolveEntry))
+   {
+      // the node is kept with the handle : a prepared request reuses it
+      m_ResolveNode.data = &m_strResolveEntry[0];
+      m_ResolveNode.next = nullptr;
+      curl_easy_setopt(m_pCurlSession, CURLOPT_RESOLVE, &m_ResolveNode);
+
+      m_llResolveTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now() - tStart).count();
+   }
+   else
+      curl_easy_setopt(m_pCurlSession, CURLOPT_RESOLVE, nullptr);
+}
+
+/**
+ * @brief requests the content of a URI
+ *
+ * @param [in] strURL URI of the remote location (with the file name) encoded in UTF-8 format.
+ * @param [out] strOutput reference to an output string.
+ * @param [out] lHTTPStatusCode HTTP Status code of the response.
+ *
+ * @retval true   Successfully requested the URI.
+ * @retval false  Encountered a problem.
+ *
+ * Example Usage:
+ * @code
+ *    std::string strWebPage;
+ *    long lHTTPStatusCode = 0;
+ *    m_pHTTOClient->GetText("https://www.google.com", strWebPage, lHTTPStatusCode);
+ * @endcode
+ */
+const bool CHTTPClient::GetText(const std::string& strURL,
+                                std::string& strOutput,
+                                long& lHTTPStatusCode)
+{
+   if (strURL.empty())
+   {
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_EMPTY_HOST);
+
+      return false;
+   }
+   if (!m_pCurlSession)
+   {
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
+
+      return false;
+   }
+   // Reset is mandatory to avoid bad surprises
+   ResetSession();
+
+   UpdateURL(strURL);
+
+   curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPGET, 1L);
+   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, WriteInStringCallback);
+   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &strOutput);
+
+   CURLcode res = Perform();
+
+   curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHTTPStatusCode);
+
+   // Check for errors
+   if (res != CURLE_OK)
+   {
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_REQUEST_FAILURE, m_strURL.c_str(), res, lHTTPStatusCode);
+
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * @brief Downloads a remote file to a local file.
+ *
+ * @param [in] strLocalFile Complete path of the local file to download in UTF-8 format.
+ * @param [in] strURL URI of the remote location (with the file name) encoded in UTF-8 format.
+ * @param [out] lHTTPStatusCode HTTP Status code of the response.
+ *
+ * @retval true   Successfully downloaded the file.
+ * @retval false  The file couldn't be downloaded. Check the log messages for more information.
+ */
+const bool CHTTPClient::DownloadFile(const std::string& strLocalFile,
+                                     const std::string& strURL,
+                                     long& lHTTPStatusCode)
+{
+   if (strURL.empty() || strLocalFile.empty())
+      return false;
+
+   if (!m_pCurlSession)
+   {
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
+
+      return false;
+   }
+   // Reset is mandatory to avoid bad surprises
+   ResetSession();
+
+   UpdateURL(strURL);
+
+   std::ofstream ofsOutput;
+   ofsOutput.open(
+#ifdef LINUX
+       strLocalFile, // UTF-8
+#else
+       Utf8ToUtf16(strLocalFile),
+#endif
+       std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+
+   if (ofsOutput)
+   {
+      curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPGET, 1L);
+      curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, WriteToFileCallback);
+      curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &ofsOutput);
+
+      m_bFileTransfer = true;
+      CURLcode res = Perform();
+      m_bFileTransfer = false;
+
+      ofsOutput.close();
+      curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHTTPStatusCode);
+
+      //double dUploadLength = 0;
+      //curl_easy_getinfo(m_pCurlSession, CURLINFO_CONTENT_LENGTH_UPLOAD, &dUploadLength); // number of bytes uploaded
+      
+      /* Delete downloaded file if status code != 200 as server's response body may
+      contain error 404 */
+      if (lHTTPStatusCode != 200)
+         remove(strLocalFile.c_str());
+
+      if (res != CURLE_OK)
+      {
+         if (m_eSettingsFlags & ENABLE_LOG)
+            Log(CHTTPAsyncLogger::EVENT_DOWNLOAD_FAILURE, strURL.c_str(), res, lHTTPStatusCode,
+                strLocalFile.c_str());
+
+         return false;
+      }
+   }
+   else if (m_eSettingsFlags & ENABLE_LOG)
+   {
+      Log(CHTTPAsyncLogger::EVENT_LOCAL_FILE_FAILURE, nullptr, CURLE_OK, 0, strLocalFile.c_str());
+
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * @brief downloads a remote file to memory
+ *
+ * @param [out] data vector of bytes
+ * @param [in] strURL URI of the remote location (with the file name) encoded in UTF-8 format.
+ * @param [out] lHTTPStatusCode HTTP Status code of the response.
+ *
+ * @retval true   Successfully downloaded the file.
+ * @retval false  The content couldn't be downloaded. Check the log messages for
+ * more information.
+ */
+const bool CHTTPClient::DownloadFile(std::vector<unsigned char>& data, const std::string& strURL, long& lHTTPStatusCode) {
+	if (strURL.empty())
+		return false;
+
+	if (!m_pCurlSession)
+	{
+		if (m_eSettingsFlags & ENABLE_LOG)
+			Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
+
+		return false;
+	}
+
+	data.clear();
+
+	// Reset is mandatory to avoid bad surprises
+	ResetSession();
+
+	UpdateURL(strURL);
+
+	curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPGET, 1L);
 	curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, WriteToMemoryCallback);
 	curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &data);
 
+	m_bFileTransfer = true;
 	CURLcode res = Perform();
+	m_bFileTransfer = false;
 
 	curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHTTPStatusCode);
 
 	if (res != CURLE_OK)
 	{
 		if (m_eSettingsFlags & ENABLE_LOG)
-			m_oLog(StringFormat(LOG_ERROR_CURL_DOWNLOAD_FAILURE_FORMAT, "Download to a byte buffer",
-				strURL.c_str(), res, curl_easy_strerror(res), lHTTPStatusCode));
+			Log(CHTTPAsyncLogger::EVENT_DOWNLOAD_FAILURE, strURL.c_str(), res, lHTTPStatusCode,
+				"Download to a byte buffer");
 
 		return false;
 	}
@@ -487,19 +1149,19 @@ const bool CHTTPClient::UploadForm(const std::string& strURL,
    if (strURL.empty())
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_EMPTY_HOST_MSG);
+         Log(CHTTPAsyncLogger::EVENT_EMPTY_HOST);
 
       return false;
    }
    if (!m_pCurlSession)
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_CURL_NOT_INIT_MSG);
+         Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
 
       return false;
    }
    // Reset is mandatory to avoid bad surprises
-   curl_easy_reset(m_pCurlSession);
+   ResetSession();
 
    UpdateURL(strURL);
 
@@ -517,7 +1179,9 @@ const bool CHTTPClient::UploadForm(const std::string& strURL,
     * CURLOPT_WRITEDATA : by default, this is a FILE * to stdout. */
    curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, ThrowAwayCallback);
 
+   m_bFileTransfer = true;
    CURLcode res = Perform();
+   m_bFileTransfer = false;
 
    curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHTTPStatusCode);
 
@@ -525,8 +1189,79 @@ const bool CHTTPClient::UploadForm(const std::string& strURL,
    if (res != CURLE_OK)
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(StringFormat(LOG_ERROR_CURL_REQ_FAILURE_FORMAT, m_strURL.c_str(), res,
-            curl_easy_strerror(res), lHTTPStatusCode));
+         Log(CHTTPAsyncLogger::EVENT_REQUEST_FAILURE, m_strURL.c_str(), res, lHTTPStatusCode);
+
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * @brief uploads a multipart/form-data form
+ * the buffers, files and producers of the form are read while the body is sent
+ *
+ * @param [in] strURL URL to which the form will be posted encoded in UTF-8 format.
+ * @param [in] Form parts to send, the form must not be modified until the request returns
+ * @param [out] lHTTPStatusCode HTTP Status code of the response.
+ *
+ * @retval true   Successfully posted the form.
+ * @retval false  The form couldn't be posted.
+ */
+const bool CHTTPClient::UploadForm(const std::string& strURL,
+                                   const CHTTPMultipartForm& Form,
+                                   long& lHTTPStatusCode)
+{
+   if (strURL.empty())
+   {
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_EMPTY_HOST);
+
+      return false;
+   }
+   if (!m_pCurlSession)
+   {
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
+
+      return false;
+   }
+   // Reset is mandatory to avoid bad surprises
+   ResetSession();
+
+   UpdateURL(strURL);
+
+   /* stating that Expect: 100-continue is not wanted */
+   AddHeader("Expect:");
+
+   CHTTPMultipartForm::MimeUpload Upload;
+   CURLcode res = Upload.Build(Form, m_pCurlSession);
+   if (res == CURLE_OK)
+   {
+      /** set the form, the method is POST */
+      curl_easy_setopt(m_pCurlSession, CURLOPT_MIMEPOST, Upload.GetMime());
+
+      /* to avoid printing response's body to stdout.
+       * CURLOPT_WRITEDATA : by default, this is a FILE * to stdout. */
+      curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, ThrowAwayCallback);
+
+      m_bResumeTransfer = false;
+      m_bPausableTransfer = Form.HasStreamedParts();
+      m_bFileTransfer = true;
+
+      res = Perform();
+
+      m_bPausableTransfer = false;
+      m_bFileTransfer = false;
+   }
+
+   curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHTTPStatusCode);
+
+   // Check for errors
+   if (res != CURLE_OK)
+   {
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_REQUEST_FAILURE, m_strURL.c_str(), res, lHTTPStatusCode);
 
       return false;
    }
@@ -598,26 +1333,26 @@ void CHTTPClient::PostFormInfo::AddFormContent(const std::string& strFieldName,
 * @param [in] Headers headers to send
 * @param [out] Response response data
 */
-inline const bool CHTTPClient::InitRestRequest(const std::string& strUrl,
+const bool CHTTPClient::InitRestRequest(const std::string& strUrl,
                                          const CHTTPClient::HeadersMap& Headers,
                                          CHTTPClient::HttpResponse& Response)
 {
    if (strUrl.empty())
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_EMPTY_HOST_MSG);
+         Log(CHTTPAsyncLogger::EVENT_EMPTY_HOST);
 
       return false;
    }
    if (!m_pCurlSession)
    {
       if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(LOG_ERROR_CURL_NOT_INIT_MSG);
+         Log(CHTTPAsyncLogger::EVENT_NOT_INIT);
 
       return false;
    }
    // Reset is mandatory to avoid bad surprises
-   curl_easy_reset(m_pCurlSession);
+   ResetSession();
 
    UpdateURL(strUrl);
 
@@ -633,72 +1368,977 @@ inline const bool CHTTPClient::InitRestRequest(const std::string& strUrl,
    // callback object for server's responses headers
    curl_easy_setopt(m_pCurlSession, CURLOPT_HEADERDATA, &Response);
 
-   std::string strHeader;
+   BuildRestHeaders(Headers);
+
+   return true;
+}
+
+/**
+* @brief builds the headers list of a REST request without allocating memory once
+* the buffers have grown : the headers added with AddHeader are sent first, then the
+* per-request headers and finally the header set (see SetHeaderSet), whose headers
+* replaced by per-request ones are skipped.
+*
+* @param [in] Headers per-request headers
+*/
+void CHTTPClient::BuildRestHeaders(const CHTTPClient::HeadersMap& Headers)
+{
+   m_pRestHeaders = nullptr;
+
+   if (m_vecHeaderLines.size() < Headers.size())
+      m_vecHeaderLines.resize(Headers.size());
+
+   size_t usLines = 0;
    for (HeadersMap::const_iterator it = Headers.cbegin();
       it != Headers.cend();
       ++it)
    {
-      strHeader = it->first + ": " + it->second; // build header string
-      AddHeader(strHeader);
+      // build header string
+      m_vecHeaderLines[usLines++].assign(it->first).append(": ").append(it->second);
    }
 
-   return true;
+   const CHTTPHeaderSet* pHeaderSet = m_pHeaderSet.get();
+   const bool bOverridden = pHeaderSet != nullptr && !Headers.empty() && pHeaderSet->IsOverridden(Headers);
+
+   size_t usNodes = usLines;
+   for (const struct curl_slist* pNode = m_pHeaderlist; pNode != nullptr; pNode = pNode->next)
+      ++usNodes;
+   if (bOverridden)
+      usNodes += pHeaderSet->GetSize();
+
+   // the nodes are linked once the vector is sized, so they don't move anymore
+   if (m_vecHeaderNodes.size() < usNodes)
+      m_vecHeaderNodes.resize(usNodes);
+
+   size_t usNode = 0;
+   auto LinkNode = [this, &usNode](char* pszLine)
+   {
+      struct curl_slist& Node = m_vecHeaderNodes[usNode];
+      Node.data = pszLine;
+      Node.next = nullptr;
+      if (usNode > 0)
+         m_vecHeaderNodes[usNode - 1].next = &Node;
+      ++usNode;
+   };
+
+   for (struct curl_slist* pNode = m_pHeaderlist; pNode != nullptr; pNode = pNode->next)
+      LinkNode(pNode->data);
+
+   for (size_t i = 0; i < usLines; ++i)
+      LinkNode(&m_vecHeaderLines[i][0]);
+
+   // libcurl only reads the lists, the header set's nodes can be shared
+   struct curl_slist* pSharedList = (pHeaderSet != nullptr) ?
+      const_cast<struct curl_slist*>(pHeaderSet->GetList()) : nullptr;
+
+   if (bOverridden)
+   {
+      for (struct curl_slist* pNode = pSharedList; pNode != nullptr; pNode = pNode->next)
+      {
+         bool bSkip = false;
+         for (HeadersMap::const_iterator it = Headers.cbegin(); !bSkip && it != Headers.cend(); ++it)
+            bSkip = CHTTPHeaderSet::HasName(pNode->data, it->first);
+
+         if (!bSkip)
+            LinkNode(pNode->data);
+      }
+      pSharedList = nullptr;
+   }
+
+   if (usNode == 0)
+      m_pRestHeaders = pSharedList;
+   else
+   {
+      // the header set is chained to the request's nodes as is
+      m_vecHeaderNodes[usNode - 1].next = pSharedList;
+      m_pRestHeaders = &m_vecHeaderNodes[0];
+   }
 }
 
 /**
 * @brief post REST request operations are performed here
 *
-* @param [in] ePerformCode curl easy perform returned code
-* @param [out] Response response data
+* @param [in] ePerformCode curl easy perform returned code
+* @param [out] Response response data
+*/
+const bool CHTTPClient::PostRestRequest(const CURLcode ePerformCode,
+                                               CHTTPClient::HttpResponse& Response)
+{
+   // Check for errors
+   if (ePerformCode != CURLE_OK)
+   {
+      Response.strBody.clear();
+      Response.iCode = -1;
+
+      if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_REST_FAILURE, m_strURL.c_str(), ePerformCode);
+
+      return false;
+   }
+   long lHttpCode = 0;
+   curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHttpCode);
+   Response.iCode = static_cast<int>(lHttpCode);
+
+   return true;
+}
+
+// REST REQUESTS CORE
+
+/* an option set by a method : the value is pszValue if it isn't null, lValue otherwise */
+struct CHTTPClient::CurlOption
+{
+   CURLoption  eOption;
+   long        lValue;
+   const char* pszValue;
+};
+
+/* body sources */
+struct CHTTPClient::NoBody
+{
+   static inline void Apply(CURL*, UploadObject&) {}
+};
+
+// the body is handed over to libcurl, which sends it from the caller's buffer
+struct CHTTPClient::PostFieldsBody
+{
+   static inline void Apply(CURL* pCurl, UploadObject& Payload)
+   {
+      // a null POSTFIELDS would make libcurl read the body from the read callback
+      curl_easy_setopt(pCurl, CURLOPT_POSTFIELDS, (Payload.pszData != nullptr) ? Payload.pszData : "");
+      curl_easy_setopt(pCurl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(Payload.usLength));
+   }
+};
+
+// the body is read by RestReadCallback
+struct CHTTPClient::ReadCallbackBody
+{
+   static inline void Apply(CURL* pCurl, UploadObject& Payload)
+   {
+      curl_easy_setopt(pCurl, CURLOPT_READFUNCTION, &CHTTPClient::RestReadCallback);
+      curl_easy_setopt(pCurl, CURLOPT_READDATA, &Payload);
+      curl_easy_setopt(pCurl, CURLOPT_INFILESIZE_LARGE, Payload.GetUploadSize());
+   }
+};
+
+// the body of a POST request is read by RestReadCallback (e.g. several buffers, a producer)
+struct CHTTPClient::ReadCallbackPostBody
+{
+   static inline void Apply(CURL* pCurl, UploadObject& Payload)
+   {
+      curl_easy_setopt(pCurl, CURLOPT_READFUNCTION, &CHTTPClient::RestReadCallback);
+      curl_easy_setopt(pCurl, CURLOPT_READDATA, &Payload);
+      curl_easy_setopt(pCurl, CURLOPT_POSTFIELDSIZE_LARGE, Payload.GetUploadSize());
+   }
+};
+
+// multipart/form-data body built by a CHTTPMultipartForm
+struct CHTTPClient::MimePostBody
+{
+   static inline void Apply(CURL* pCurl, UploadObject& Payload)
+   {
+      curl_easy_setopt(pCurl, CURLOPT_MIMEPOST, Payload.pMime);
+   }
+};
+
+/* methods : options to set, default body source and whether the request can be sent
+ * in data that may be replayed (TCP Fast Open, TLS early data) */
+struct CHTTPClient::HeadMethod
+{
+   typedef NoBody BodySource;
+   static constexpr bool bReplaySafe = true;
+   static constexpr CurlOption Options[] = { { CURLOPT_CUSTOMREQUEST, 0, "HEAD" },
+                                             { CURLOPT_NOBODY, 1L, nullptr } };
+};
+struct CHTTPClient::GetMethod
+{
+   typedef NoBody BodySource;
+   static constexpr bool bReplaySafe = true;
+   static constexpr CurlOption Options[] = { { CURLOPT_HTTPGET, 1L, nullptr } };
+};
+struct CHTTPClient::DeleteMethod
+{
+   typedef NoBody BodySource;
+   static constexpr bool bReplaySafe = false;
+   static constexpr CurlOption Options[] = { { CURLOPT_CUSTOMREQUEST, 0, "DELETE" } };
+};
+struct CHTTPClient::PostMethod
+{
+   typedef PostFieldsBody BodySource;
+   static constexpr bool bReplaySafe = false;
+   static constexpr CurlOption Options[] = { { CURLOPT_POST, 1L, nullptr } };
+};
+struct CHTTPClient::PutMethod
+{
+   typedef ReadCallbackBody BodySource;
+   static constexpr bool bReplaySafe = false;
+   static constexpr CurlOption Options[] = { { CURLOPT_UPLOAD, 1L, nullptr } };
+};
+struct CHTTPClient::PatchMethod
+{
+   typedef PostFieldsBody BodySource;
+   static constexpr bool bReplaySafe = false;
+   static constexpr CurlOption Options[] = { { CURLOPT_POST, 1L, nullptr },
+                                             { CURLOPT_CUSTOMREQUEST, 0, "PATCH" } };
+};
+struct CHTTPClient::OptionsMethod
+{
+   typedef NoBody BodySource;
+   static constexpr bool bReplaySafe = false;
+   static constexpr CurlOption Options[] = { { CURLOPT_CUSTOMREQUEST, 0, "OPTIONS" } };
+};
+
+// definitions of the tables (required before C++17)
+constexpr CHTTPClient::CurlOption CHTTPClient::HeadMethod::Options[];
+constexpr CHTTPClient::CurlOption CHTTPClient::GetMethod::Options[];
+constexpr CHTTPClient::CurlOption CHTTPClient::DeleteMethod::Options[];
+constexpr CHTTPClient::CurlOption CHTTPClient::PostMethod::Options[];
+constexpr CHTTPClient::CurlOption CHTTPClient::PutMethod::Options[];
+constexpr CHTTPClient::CurlOption CHTTPClient::PatchMethod::Options[];
+constexpr CHTTPClient::CurlOption CHTTPClient::OptionsMethod::Options[];
+
+/**
+* @brief sets the options of a table, the tables being known at compile time,
+* the loop is unrolled into plain setopt calls
+*/
+template <size_t N>
+inline void CHTTPClient::SetCurlOptions(CURL* pCurl, const CurlOption (&Options)[N])
+{
+   for (size_t i = 0; i < N; ++i)
+   {
+      if (Options[i].pszValue != nullptr)
+         curl_easy_setopt(pCurl, Options[i].eOption, Options[i].pszValue);
+      else
+         curl_easy_setopt(pCurl, Options[i].eOption, Options[i].lValue);
+   }
+}
+
+/**
+* @brief sets the options of a REST method and its body source
+*
+* @param [in/out] Payload data to send (ignored if the body source is NoBody),
+* it must remain valid until the end of the transfer
+*/
+template <class Method, class BodySource>
+void CHTTPClient::SetRestOptions(UploadObject& Payload)
+{
+   SetCurlOptions(m_pCurlSession, Method::Options);
+   BodySource::Apply(m_pCurlSession, Payload);
+
+   if (m_bFastOpen && Method::bReplaySafe)
+      ApplyFastOpen();
+}
+
+/**
+* @brief performs a REST request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in/out] Payload data to send (ignored if the body source is NoBody)
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+template <class Method, class BodySource>
+const bool CHTTPClient::RestRequest(const std::string& strUrl, const HeadersMap& Headers,
+                                    UploadObject& Payload, HttpResponse& Response)
+{
+   if (!InitRestRequest(strUrl, Headers, Response))
+      return false;
+
+   SetRestOptions<Method, BodySource>(Payload);
+
+   CURLcode res = Perform();
+
+   return PostRestRequest(res, Response);
+}
+
+/**
+* @brief performs a REST request and returns its response by value
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] Body data to send (ignored if the body source is NoBody)
+*
+* @retval HttpResponse response data, its code is -1 if the request failed
+*/
+template <class Method, class BodySource>
+CHTTPClient::HttpResponse CHTTPClient::RestRequest(const std::string& strUrl, const HeadersMap& Headers,
+                                                   const BodyView& Body)
+{
+   HttpResponse Response;
+
+   // the body buffer of the last recycled response is reused
+   Response.strBody.swap(m_strRecycledBody);
+   Response.strBody.clear();
+
+   UploadObject Payload;
+   Payload.pszData = Body.pszData;
+   Payload.usLength = Body.usLength;
+
+   if (!RestRequest<Method, BodySource>(strUrl, Headers, Payload, Response))
+      Response.iCode = -1;
+
+   return Response;
+}
+
+/**
+* @brief performs a REST request whose body is produced on demand
+* the body is sent with "Transfer-Encoding: chunked" if its length is unknown
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] Body producer of the data to send and length of the data (-1 if unknown)
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem (or the producer aborted the request).
+*/
+template <class Method, class BodySource>
+const bool CHTTPClient::StreamRequest(const std::string& strUrl, const HeadersMap& Headers,
+                                      const BodyStream& Body, HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pfnProducer = &Body.fnProducer;
+   Payload.iStreamLength = Body.iLength;
+
+   m_bResumeTransfer = false;
+   m_bPausableTransfer = true;
+
+   const bool bSuccess = RestRequest<Method, BodySource>(strUrl, Headers, Payload, Response);
+
+   m_bPausableTransfer = false;
+
+   return bSuccess;
+}
+
+/**
+* @brief sets the method of a REST request and the data it sends, when the method
+* is only known at runtime (prepared requests, transfer engine)
+*
+* @param [in] eMethod HTTP method
+* @param [in] strBody data to send on POST, PUT and PATCH requests (ignored otherwise),
+* it must remain valid until the end of the transfer
+* @param [out] Payload upload object read by RestReadCallback on PUT requests
+*/
+void CHTTPClient::SetRestMethod(const RestMethod eMethod, const std::string& strBody, UploadObject& Payload)
+{
+   typedef void (CHTTPClient::*SetRestOptionsFn)(UploadObject&);
+
+   // indexed by RestMethod
+   static const SetRestOptionsFn s_SetRestOptions[] =
+   {
+      &CHTTPClient::SetRestOptions<HeadMethod>,
+      &CHTTPClient::SetRestOptions<GetMethod>,
+      &CHTTPClient::SetRestOptions<DeleteMethod>,
+      &CHTTPClient::SetRestOptions<PostMethod>,
+      &CHTTPClient::SetRestOptions<PutMethod>,
+      &CHTTPClient::SetRestOptions<PatchMethod>,
+      &CHTTPClient::SetRestOptions<OptionsMethod>
+   };
+   static_assert(sizeof(s_SetRestOptions) / sizeof(s_SetRestOptions[0]) == REST_OPTIONS + 1,
+                 "a REST method is missing");
+
+   Payload.pszData = strBody.c_str();
+   Payload.usLength = strBody.size();
+
+   (this->*s_SetRestOptions[eMethod])(Payload);
+}
+
+/**
+* @brief performs a HEAD request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Head(const std::string& strUrl,
+   const CHTTPClient::HeadersMap& Headers,
+   CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   return RestRequest<HeadMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a GET request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Get(const std::string& strUrl,
+   const CHTTPClient::HeadersMap& Headers,
+   CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   return RestRequest<GetMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a DELETE request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Del(const std::string& strUrl,
+   const CHTTPClient::HeadersMap& Headers,
+   CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   return RestRequest<DeleteMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a POST request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] strPostData data to send
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Post(const std::string& strUrl,
+   const CHTTPClient::HeadersMap& Headers,
+   const std::string& strPostData,
+   CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pszData = strPostData.c_str();
+   Payload.usLength = strPostData.size();
+
+   return RestRequest<PostMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a PUT request with a string
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Put(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const std::string& strPutData, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pszData = strPutData.c_str();
+   Payload.usLength = strPutData.size();
+
+   return RestRequest<PutMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a PUT request with a byte buffer (vector of char)
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Put(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::ByteBuffer& Data, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pszData = Data.data();
+   Payload.usLength = Data.size();
+
+   return RestRequest<PutMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a PATCH request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] strPatchData data to send
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Patch(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const std::string& strPatchData, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pszData = strPatchData.c_str();
+   Payload.usLength = strPatchData.size();
+
+   return RestRequest<PatchMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs an OPTIONS request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Options(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   return RestRequest<OptionsMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a POST request with a body view
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PostData data to send, it isn't copied
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Post(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodyView& PostData, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pszData = PostData.pszData;
+   Payload.usLength = PostData.usLength;
+
+   return RestRequest<PostMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a PUT request with a body view
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PutData data to send, it isn't copied
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Put(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodyView& PutData, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pszData = PutData.pszData;
+   Payload.usLength = PutData.usLength;
+
+   return RestRequest<PutMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a PATCH request with a body view
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PatchData data to send, it isn't copied
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Patch(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodyView& PatchData, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pszData = PatchData.pszData;
+   Payload.usLength = PatchData.usLength;
+
+   return RestRequest<PatchMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a POST request with a body made of several buffers
+* the buffers are sent in sequence, the Content-Length is the sum of their lengths
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PostData buffers to send, they aren't concatenated
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Post(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodySegments& PostData, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pSegments = PostData.data();
+   Payload.usSegmentsCount = PostData.size();
+
+   return RestRequest<PostMethod, ReadCallbackPostBody>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a PUT request with a body made of several buffers
+* the buffers are sent in sequence, the Content-Length is the sum of their lengths
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PutData buffers to send, they aren't concatenated
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Put(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodySegments& PutData, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pSegments = PutData.data();
+   Payload.usSegmentsCount = PutData.size();
+
+   return RestRequest<PutMethod>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a PATCH request with a body made of several buffers
+* the buffers are sent in sequence, the Content-Length is the sum of their lengths
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PatchData buffers to send, they aren't concatenated
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Patch(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodySegments& PatchData, CHTTPClient::HttpResponse& Response)
+{
+   UploadObject Payload;
+   Payload.pSegments = PatchData.data();
+   Payload.usSegmentsCount = PatchData.size();
+
+   return RestRequest<PatchMethod, ReadCallbackPostBody>(strUrl, Headers, Payload, Response);
+}
+
+/**
+* @brief performs a POST request with a body produced on demand
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PostData producer of the data to send and its length (-1 if unknown)
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Post(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodyStream& PostData, CHTTPClient::HttpResponse& Response)
+{
+   return StreamRequest<PostMethod, ReadCallbackPostBody>(strUrl, Headers, PostData, Response);
+}
+
+/**
+* @brief performs a PUT request with a body produced on demand
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PutData producer of the data to send and its length (-1 if unknown)
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Put(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodyStream& PutData, CHTTPClient::HttpResponse& Response)
+{
+   return StreamRequest<PutMethod, ReadCallbackBody>(strUrl, Headers, PutData, Response);
+}
+
+/**
+* @brief performs a PATCH request with a body produced on demand
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PatchData producer of the data to send and its length (-1 if unknown)
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Patch(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPClient::BodyStream& PatchData, CHTTPClient::HttpResponse& Response)
+{
+   return StreamRequest<PatchMethod, ReadCallbackPostBody>(strUrl, Headers, PatchData, Response);
+}
+
+/**
+* @brief performs a POST request sending a multipart/form-data body
+* the buffers, files and producers of the form are read while the body is sent
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] Form parts to send, the form must not be modified until the request returns
+* @param [out] Response response data
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem (or a producer aborted the request).
+*/
+const bool CHTTPClient::Post(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   const CHTTPMultipartForm& Form, CHTTPClient::HttpResponse& Response)
+{
+   if (!InitRestRequest(strUrl, Headers, Response))
+      return false;
+
+   CHTTPMultipartForm::MimeUpload Upload;
+   const CURLcode eBuildCode = Upload.Build(Form, m_pCurlSession);
+   if (eBuildCode != CURLE_OK)
+      return PostRestRequest(eBuildCode, Response);
+
+   UploadObject Payload;
+   Payload.pMime = Upload.GetMime();
+   SetRestOptions<PostMethod, MimePostBody>(Payload);
+
+   // a producer may pause the upload
+   m_bResumeTransfer = false;
+   m_bPausableTransfer = Form.HasStreamedParts();
+
+   CURLcode res = Perform();
+
+   m_bPausableTransfer = false;
+
+   return PostRestRequest(res, Response);
+}
+
+/**
+* @brief performs a GET request whose body is received in a bounded stream
+* the transfer is paused while the stream is full and resumed when it is read, the
+* stream is closed when the request returns (whatever its outcome)
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [out] Body stream receiving the response's body, read by a consumer
+* @param [out] Response response's code and headers (its body stays empty)
+*
+* @retval true   Successfully requested the URI.
+* @retval false  Encountered a problem.
+*/
+const bool CHTTPClient::Get(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   CHTTPResponseStream& Body, CHTTPClient::HttpResponse& Response)
+{
+   Body.Open([this]() { ResumeTransfer(); });
+
+   if (!InitRestRequest(strUrl, Headers, Response))
+   {
+      Body.Close(false);
+      return false;
+   }
+
+   UploadObject Payload;
+   SetRestOptions<GetMethod>(Payload);
+
+   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, &CHTTPClient::StreamWriteCallback);
+   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &Body);
+
+   m_bResumeTransfer = false;
+   m_bPausableTransfer = true;
+
+   CURLcode res = Perform();
+
+   m_bPausableTransfer = false;
+
+   Body.Close(res == CURLE_OK);
+
+   return PostRestRequest(res, Response);
+}
+
+/**
+* @brief performs a GET request whose JSON body is parsed while it is received
+* the parser's handler gets the events during the transfer, the transfer is aborted as soon
+* as the body isn't valid JSON or the handler stops the parsing
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in/out] Body parser receiving the response's body, it is reset first
+* @param [out] Response response's code and headers (its body stays empty)
+*
+* @retval true   Successfully requested the URI and parsed a complete JSON document.
+* @retval false  Encountered a problem (see Body.GetError() for the parsing errors).
+*/
+const bool CHTTPClient::Get(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   CHTTPJsonStream& Body, CHTTPClient::HttpResponse& Response)
+{
+   Body.Reset();
+
+   if (!InitRestRequest(strUrl, Headers, Response))
+      return false;
+
+   UploadObject Payload;
+   SetRestOptions<GetMethod>(Payload);
+
+   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, &CHTTPClient::JsonWriteCallback);
+   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &Body);
+
+   CURLcode res = Perform();
+
+   return PostRestRequest(res, Response) && Body.Finish();
+}
+
+/**
+* @brief performs a GET request whose body is split into lines while it is received
+* the transfer is aborted as soon as the reader is stopped
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in/out] Body reader receiving the response's body, it is reset first
+* @param [out] Response response's code and headers (its body stays empty)
+*
+* @retval true   Successfully requested the URI and read the whole body.
+* @retval false  Encountered a problem or the reader was stopped.
+*/
+const bool CHTTPClient::Get(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   CHTTPLineReader& Body, CHTTPClient::HttpResponse& Response)
+{
+   Body.Reset();
+
+   if (!InitRestRequest(strUrl, Headers, Response))
+      return false;
+
+   UploadObject Payload;
+   SetRestOptions<GetMethod>(Payload);
+
+   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, &CHTTPClient::LineWriteCallback);
+   curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &Body);
+
+   CURLcode res = Perform();
+
+   return PostRestRequest(res, Response) && Body.Finish();
+}
+
+namespace
+{
+// state of a Server-Sent Events connection, passed to EventWriteCallback
+struct EventConnection
+{
+   CHTTPEventReader* pReader;
+   CURL*             pCurl;
+   bool              bChecked; // the response was checked
+   bool              bValid;   // 200 and text/event-stream
+};
+}
+
+/**
+* @brief listens to a Server-Sent Events stream
+* the events are dispatched to the reader while they are received. When the connection
+* is lost (or the server closes it), it is re-established after the reader's retry delay,
+* with the Last-Event-ID header if an id was received.
+*
+* @param [in] strUrl url of the stream encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in/out] Events reader receiving the stream, its last event id and retry delay
+* are used and updated
+* @param [out] Response code and headers of the last connection (its body stays empty)
+* @param [in] uMaxReconnects reconnections in a row without receiving an event (0 : no limit)
+*
+* @retval true   Listening was stopped by the reader or by the server (204 No Content).
+* @retval false  The server refused the stream (status other than 200 or not a
+* text/event-stream) or the reconnections limit was reached.
 */
-inline const bool CHTTPClient::PostRestRequest(const CURLcode ePerformCode,
-                                               CHTTPClient::HttpResponse& Response)
+const bool CHTTPClient::Subscribe(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+   CHTTPEventReader& Events, CHTTPClient::HttpResponse& Response,
+   const unsigned uMaxReconnects /* = 0 */)
 {
-   // Check for errors
-   if (ePerformCode != CURLE_OK)
+   HeadersMap StreamHeaders(Headers);
+   StreamHeaders.emplace("Accept", "text/event-stream");
+   StreamHeaders.emplace("Cache-Control", "no-cache");
+
+   unsigned uReconnects = 0;
+   for (;;)
    {
-      Response.strBody.clear();
-      Response.iCode = -1;
+      Events.Reset();
 
-      if (m_eSettingsFlags & ENABLE_LOG)
-         m_oLog(StringFormat(LOG_ERROR_CURL_REST_FAILURE_FORMAT, m_strURL.c_str(), ePerformCode,
-            curl_easy_strerror(ePerformCode)));
+      if (Events.GetLastEventId().empty())
+         StreamHeaders.erase("Last-Event-ID");
+      else
+         StreamHeaders["Last-Event-ID"] = Events.GetLastEventId();
 
-      return false;
-   }
-   long lHttpCode = 0;
-   curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHttpCode);
-   Response.iCode = static_cast<int>(lHttpCode);
+      Response.iCode = 0;
+      Response.mapHeaders.clear();
+      if (!InitRestRequest(strUrl, StreamHeaders, Response))
+         return false;
 
-   return true;
+      UploadObject Payload;
+      SetRestOptions<GetMethod>(Payload);
+
+      EventConnection Connection = { &Events, m_pCurlSession, false, false };
+      curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEFUNCTION, &CHTTPClient::EventWriteCallback);
+      curl_easy_setopt(m_pCurlSession, CURLOPT_WRITEDATA, &Connection);
+
+      const size_t usEvents = Events.GetEventsCount();
+
+      CURLcode res = Perform();
+
+      if (Events.IsStopped())
+      {
+         long lHttpCode = 0;
+         curl_easy_getinfo(m_pCurlSession, CURLINFO_RESPONSE_CODE, &lHttpCode);
+         Response.iCode = static_cast<int>(lHttpCode);
+         return true;
+      }
+
+      if (res == CURLE_OK)
+      {
+         PostRestRequest(res, Response);
+
+         // 204 : the server asks the client to stop
+         if (Response.iCode == 204)
+            return true;
+
+         if (!Connection.bChecked || !Connection.bValid)
+            return false;
+      }
+      else if (m_eSettingsFlags & ENABLE_LOG)
+         Log(CHTTPAsyncLogger::EVENT_REST_FAILURE, m_strURL.c_str(), res);
+
+      // the connection was lost or closed by the server
+      uReconnects = (Events.GetEventsCount() > usEvents) ? 1 : uReconnects + 1;
+      if (uMaxReconnects > 0 && uReconnects > uMaxReconnects)
+      {
+         Response.iCode = -1;
+         return false;
+      }
+
+      // wait for the retry delay, Stop() is checked periodically
+      for (long lWaitedMs = 0; lWaitedMs < Events.GetRetryDelay() && !Events.IsStopped(); lWaitedMs += 100)
+         std::this_thread::sleep_for(std::chrono::milliseconds(
+            std::min<long>(100, Events.GetRetryDelay() - lWaitedMs)));
+
+      if (Events.IsStopped())
+         return true;
+   }
 }
 
+// REST REQUESTS RETURNING THEIR RESPONSE
+
 /**
 * @brief performs a HEAD request
 *
 * @param [in] strUrl url to request encoded in UTF-8 format.
 * @param [in] Headers headers to send
-* @param [out] Response response data
 *
-* @retval true   Successfully requested the URI.
-* @retval false  Encountered a problem.
+* @retval HttpResponse response data, its code is -1 if the request failed
 */
-const bool CHTTPClient::Head(const std::string& strUrl,
-   const CHTTPClient::HeadersMap& Headers,
-   CHTTPClient::HttpResponse& Response)
+CHTTPClient::HttpResponse CHTTPClient::Head(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers)
 {
-   if (InitRestRequest(strUrl, Headers, Response))
-   {
-      /** set HTTP HEAD METHOD */
-      curl_easy_setopt(m_pCurlSession, CURLOPT_CUSTOMREQUEST, "HEAD");
-      curl_easy_setopt(m_pCurlSession, CURLOPT_NOBODY, 1L);
-
-      CURLcode res = Perform();
-
-      return PostRestRequest(res, Response);
-   }
-   else
-      return false;
+   return RestRequest<HeadMethod>(strUrl, Headers, BodyView());
 }
 
 /**
@@ -706,26 +2346,12 @@ const bool CHTTPClient::Head(const std::string& strUrl,
 *
 * @param [in] strUrl url to request encoded in UTF-8 format.
 * @param [in] Headers headers to send
-* @param [out] Response response data
 *
-* @retval true   Successfully requested the URI.
-* @retval false  Encountered a problem.
+* @retval HttpResponse response data, its code is -1 if the request failed
 */
-const bool CHTTPClient::Get(const std::string& strUrl,
-   const CHTTPClient::HeadersMap& Headers,
-   CHTTPClient::HttpResponse& Response)
+CHTTPClient::HttpResponse CHTTPClient::Get(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers)
 {
-   if (InitRestRequest(strUrl, Headers, Response))
-   {
-      // specify a GET request
-      curl_easy_setopt(m_pCurlSession, CURLOPT_HTTPGET, 1L);
-
-      CURLcode res = Perform();
-
-      return PostRestRequest(res, Response);
-   }
-   else
-      return false;
+   return RestRequest<GetMethod>(strUrl, Headers, BodyView());
 }
 
 /**
@@ -733,127 +2359,275 @@ const bool CHTTPClient::Get(const std::string& strUrl,
 *
 * @param [in] strUrl url to request encoded in UTF-8 format.
 * @param [in] Headers headers to send
-* @param [out] Response response data
 *
-* @retval true   Successfully requested the URI.
-* @retval false  Encountered a problem.
+* @retval HttpResponse response data, its code is -1 if the request failed
 */
-const bool CHTTPClient::Del(const std::string& strUrl,
-   const CHTTPClient::HeadersMap& Headers,
-   CHTTPClient::HttpResponse& Response)
+CHTTPClient::HttpResponse CHTTPClient::Del(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers)
 {
-   if (InitRestRequest(strUrl, Headers, Response))
-   {
-      curl_easy_setopt(m_pCurlSession, CURLOPT_CUSTOMREQUEST, "DELETE");
+   return RestRequest<DeleteMethod>(strUrl, Headers, BodyView());
+}
 
-      CURLcode res = Perform();
+/**
+* @brief performs a POST request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PostData data to send, it isn't copied
+*
+* @retval HttpResponse response data, its code is -1 if the request failed
+*/
+CHTTPClient::HttpResponse CHTTPClient::Post(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+                                            const CHTTPClient::BodyView& PostData)
+{
+   return RestRequest<PostMethod>(strUrl, Headers, PostData);
+}
 
-      return PostRestRequest(res, Response);
-   }
-   else
-      return false;
+/**
+* @brief performs a PUT request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PutData data to send, it isn't copied
+*
+* @retval HttpResponse response data, its code is -1 if the request failed
+*/
+CHTTPClient::HttpResponse CHTTPClient::Put(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+                                           const CHTTPClient::BodyView& PutData)
+{
+   return RestRequest<PutMethod>(strUrl, Headers, PutData);
 }
 
-const bool CHTTPClient::Post(const std::string& strUrl,
-   const CHTTPClient::HeadersMap& Headers,
-   const std::string& strPostData,
-   CHTTPClient::HttpResponse& Response)
+/**
+* @brief performs a PATCH request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+* @param [in] PatchData data to send, it isn't copied
+*
+* @retval HttpResponse response data, its code is -1 if the request failed
+*/
+CHTTPClient::HttpResponse CHTTPClient::Patch(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
+                                             const CHTTPClient::BodyView& PatchData)
 {
-   if (InitRestRequest(strUrl, Headers, Response))
-   {
-      // specify a POST request
-      curl_easy_setopt(m_pCurlSession, CURLOPT_POST, 1L);
+   return RestRequest<PatchMethod>(strUrl, Headers, PatchData);
+}
 
-      // set post informations
-      curl_easy_setopt(m_pCurlSession, CURLOPT_POSTFIELDS, strPostData.c_str());
-      curl_easy_setopt(m_pCurlSession, CURLOPT_POSTFIELDSIZE, strPostData.size());
+/**
+* @brief performs an OPTIONS request
+*
+* @param [in] strUrl url to request encoded in UTF-8 format.
+* @param [in] Headers headers to send
+*
+* @retval HttpResponse response data, its code is -1 if the request failed
+*/
+CHTTPClient::HttpResponse CHTTPClient::Options(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers)
+{
+   return RestRequest<OptionsMethod>(strUrl, Headers, BodyView());
+}
 
-      CURLcode res = Perform();
+/**
+* @brief gives back a response that is no longer used
+* its body buffer is reused by the next request returning its response by value
+*
+* @param [in] Response response to recycle
+*/
+void CHTTPClient::RecycleResponse(CHTTPClient::HttpResponse&& Response)
+{
+   // keep the largest buffer
+   if (Response.strBody.capacity() > m_strRecycledBody.capacity())
+      m_strRecycledBody.swap(Response.strBody);
 
-      return PostRestRequest(res, Response);
-   }
-   else
-      return false;
+   Response.strBody.clear();
 }
 
+// PREPARED REST REQUESTS
+
 /**
-* @brief performs a PUT request with a string
+* @brief constructor of a prepared REST request, nothing is sent until it is executed
 *
+* @param [in] eMethod HTTP method
 * @param [in] strUrl url to request encoded in UTF-8 format.
-* @param [in] Headers headers to send
-* @param [out] Response response data
+* @param [in] Headers headers to send (layered on top of the client's header set)
+* @param [in] strBody data to send on POST, PUT and PATCH requests
+* @param [in] iTimeout timeout in seconds (0 : none), -1 to use the client's timeout
+*/
+CHTTPClient::PreparedRequest::PreparedRequest(const RestMethod eMethod, const std::string& strUrl,
+                                              const HeadersMap& Headers /* = HeadersMap() */,
+                                              const std::string& strBody /* = std::string() */,
+                                              const int iTimeout /* = -1 */) :
+   m_ulId(NewId()),
+   m_eMethod(eMethod),
+   m_strUrl(strUrl),
+   m_Headers(Headers),
+   m_strBody(strBody),
+   m_iTimeout(iTimeout),
+   m_bAbstractUnixSocket(false)
+{
+}
+
+/**
+* @brief replaces the data sent on POST, PUT and PATCH requests
 *
-* @retval true   Successfully requested the URI.
-* @retval false  Encountered a problem.
+* @param [in] strBody data to send
 */
-const bool CHTTPClient::Put(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
-   const std::string& strPutData, CHTTPClient::HttpResponse& Response)
+void CHTTPClient::PreparedRequest::SetBody(const std::string& strBody)
 {
-   if (InitRestRequest(strUrl, Headers, Response))
-   {
-      CHTTPClient::UploadObject Payload;
+   m_strBody = strBody;
 
-      Payload.pszData = strPutData.c_str();
-      Payload.usLength = strPutData.size();
+   // sessions configured for this request must configure their handle again
+   m_ulId = NewId();
+}
 
-      // specify a PUT request
-      curl_easy_setopt(m_pCurlSession, CURLOPT_PUT, 1L);
-      curl_easy_setopt(m_pCurlSession, CURLOPT_UPLOAD, 1L);
+/**
+* @brief sends the request through a Unix domain socket instead of the session's transport
+*
+* @param [in] strPath path of the socket (or name in the abstract namespace), empty to use
+* the session's transport
+* @param [in] bAbstract the socket is in the abstract namespace (Linux)
+*/
+void CHTTPClient::PreparedRequest::SetUnixSocketPath(const std::string& strPath, const bool bAbstract /* = false */)
+{
+   m_strUnixSocketPath = strPath;
+   m_bAbstractUnixSocket = bAbstract;
 
-      // set read callback function
-      curl_easy_setopt(m_pCurlSession, CURLOPT_READFUNCTION, &CHTTPClient::RestReadCallback);
-      // set data object to pass to callback function
-      curl_easy_setopt(m_pCurlSession, CURLOPT_READDATA, &Payload);
+   // sessions configured for this request must configure their handle again
+   m_ulId = NewId();
+}
 
-      // set data size
-      curl_easy_setopt(m_pCurlSession, CURLOPT_INFILESIZE, static_cast<long>(Payload.usLength));
+/**
+* @brief tunes the new connections of the request with a profile instead of the session's one
+*
+* @param [in] pSocketProfile profile, nullptr to use the session's one
+*/
+void CHTTPClient::PreparedRequest::SetSocketProfile(std::shared_ptr<const CHTTPSocketProfile> pSocketProfile)
+{
+   m_pSocketProfile = std::move(pSocketProfile);
 
-      CURLcode res = Perform();
+   // sessions configured for this request must configure their handle again
+   m_ulId = NewId();
+}
 
-      return PostRestRequest(res, Response);
-   }
-   else
-      return false;
+/**
+* @brief returns a process-wide unique identifier (never 0)
+*/
+const uint64_t CHTTPClient::PreparedRequest::NewId()
+{
+   static std::atomic<uint64_t> s_ulNextId(1);
+   return s_ulNextId.fetch_add(1, std::memory_order_relaxed);
 }
 
 /**
-* @brief performs a PUT request with a byte buffer (vector of char)
+* @brief executes a prepared REST request
+* the handle is fully configured on the first execution only, next executions just
+* perform the transfer as long as the handle isn't used by another request
 *
-* @param [in] strUrl url to request encoded in UTF-8 format.
-* @param [in] Headers headers to send
-* @param [out] Response response data
+* @param [in/out] Request prepared request, its response is available with GetResponse()
 *
 * @retval true   Successfully requested the URI.
 * @retval false  Encountered a problem.
 */
-const bool CHTTPClient::Put(const std::string& strUrl, const CHTTPClient::HeadersMap& Headers,
-   const CHTTPClient::ByteBuffer& Data, CHTTPClient::HttpResponse& Response)
+const bool CHTTPClient::Execute(PreparedRequest& Request)
 {
-   if (InitRestRequest(strUrl, Headers, Response))
+   HttpResponse& Response = Request.m_Response;
+
+   // buffers are kept
+   Response.iCode = 0;
+   Response.strBody.clear();
+   Response.mapHeaders.clear();
+
+   // the handle is configured again if the CA file changed : only a reset restores
+   // libcurl's default bundle
+   if (!m_pCurlSession || m_ulPreparedId != Request.m_ulId
+       || m_ulCertificationAuthorityGeneration != s_ulCertificationAuthorityGeneration.load())
    {
-      CHTTPClient::UploadObject Payload;
+      if (!InitRestRequest(Request.m_strUrl, Request.m_Headers, Response))
+         return false;
 
-      Payload.pszData = Data.data();
-      Payload.usLength = Data.size();
+      SetRestMethod(Request.m_eMethod, Request.m_strBody, Request.m_Payload);
 
-      // specify a PUT request
-      curl_easy_setopt(m_pCurlSession, CURLOPT_PUT, 1L);
-      curl_easy_setopt(m_pCurlSession, CURLOPT_UPLOAD, 1L);
+      CURLcode res = PrepareTransfer();
+      if (res != CURLE_OK)
+         return PostRestRequest(res, Response);
 
-      // set read callback function
-      curl_easy_setopt(m_pCurlSession, CURLOPT_READFUNCTION, &CHTTPClient::RestReadCallback);
-      // set data object to pass to callback function
-      curl_easy_setopt(m_pCurlSession, CURLOPT_READDATA, &Payload);
+      if (Request.m_iTimeout >= 0)
+      {
+         curl_easy_setopt(m_pCurlSession, CURLOPT_TIMEOUT, static_cast<long>(Request.m_iTimeout));
+         if (Request.m_iTimeout > 0)
+            curl_easy_setopt(m_pCurlSession, CURLOPT_NOSIGNAL, 1L);
+      }
 
-      // set data size
-      curl_easy_setopt(m_pCurlSession, CURLOPT_INFILESIZE, static_cast<long>(Payload.usLength));
+      if (!Request.m_strUnixSocketPath.empty())
+      {
+         SetUnixSocket(m_pCurlSession, Request.m_strUnixSocketPath, Request.m_bAbstractUnixSocket);
+         m_usLocalAddress = CHTTPLocalAddressPool::NO_ADDRESS;
+      }
 
-      CURLcode res = Perform();
+      if (Request.m_pSocketProfile)
+         Request.m_pSocketProfile->Apply(m_pCurlSession);
 
-      return PostRestRequest(res, Response);
+      // the headers added with AddHeader are freed after the transfer, the handle
+      // can't be reused as is
+      m_ulPreparedId = (m_pHeaderlist == nullptr) ? Request.m_ulId : 0;
    }
    else
-      return false;
+   {
+      // the URL, the headers and the options are still set : rewind the payload
+      Request.m_Payload.pszData = Request.m_strBody.c_str();
+      Request.m_Payload.usLength = Request.m_strBody.size();
+
+      // the addresses may have been refreshed since the last execution
+      ApplyDnsCache();
+
+      // and the certificates reloaded
+      if (m_pCertificateStore && m_pCertificates
+          && m_pCertificateStore->GetGeneration() != m_pCertificates->ulGeneration)
+         ApplyCertificates();
+
+      // the least loaded proxy
+      if (m_pProxyPool)
+         m_usProxy = m_pProxyPool->Acquire(m_pCurlSession);
+
+      // the sizes adapted to the previous execution
+      if (m_bAdaptiveBuffers)
+         ApplyBufferSizes();
+
+      // the next address in turn
+      if (m_pLocalAddressPool && m_strUnixSocketPath.empty() && Request.m_strUnixSocketPath.empty())
+         m_usLocalAddress = m_pLocalAddressPool->Acquire(m_pCurlSession);
+
+#ifdef DEBUG_CURL
+      StartCurlDebug();
+#endif
+   }
+
+   CURLcode res = FailOver(curl_easy_perform(m_pCurlSession));
+
+   FinishTransfer(res);
+
+   return PostRestRequest(res, Response);
+}
+
+// LOG HELPERS
+
+/**
+ * @brief logs an event : the message is handed over to the asynchronous logger if one
+ * is set and running, otherwise it is formatted and printed right away
+ *
+ * @param [in] eEvent logged event
+ * @param [in] pszUrl URL of the request
+ * @param [in] eCode libcurl code
+ * @param [in] lStatus HTTP status code
+ * @param [in] pszLocalFile local file path
+ */
+void CHTTPClient::Log(const CHTTPAsyncLogger::LogEvent eEvent, const char* pszUrl /* = nullptr */,
+                      const CURLcode eCode /* = CURLE_OK */, const long lStatus /* = 0 */,
+                      const char* pszLocalFile /* = nullptr */) const
+{
+   if (m_pAsyncLogger != nullptr && m_pAsyncLogger->Push(eEvent, pszUrl, eCode, lStatus, pszLocalFile))
+      return;
+
+   if (m_oLog)
+      m_oLog(CHTTPAsyncLogger::FormatLogMessage(eEvent, pszUrl, eCode, lStatus, pszLocalFile));
 }
 
 // STRING HELPERS
@@ -1083,17 +2857,161 @@ size_t CHTTPClient::RestReadCallback(void* pCurlData, size_t usBlockCount, size_
 
    // set correct sizes
    size_t usCurlSize = usBlockCount * usBlockSize;
-   size_t usCopySize = (Payload->usLength < usCurlSize) ? Payload->usLength : usCurlSize;
 
-   /** copy data to buffer */
-   std::memcpy(pCurlData, Payload->pszData, usCopySize);
+   // streamed body : the producer writes in libcurl's buffer (or pauses/aborts the upload)
+   if (Payload->pfnProducer != nullptr)
+      return (*Payload->pfnProducer)(static_cast<char*>(pCurlData), usCurlSize);
+
+   size_t usCopiedSize = 0;
+   char* pszCurlData = static_cast<char*>(pCurlData);
 
-   // decrement length and increment data pointer
-   Payload->usLength -= usCopySize; // remaining bytes to be sent
-   Payload->pszData += usCopySize;  // next byte to the chunk that will be sent
+   while (usCopiedSize < usCurlSize)
+   {
+      if (Payload->usLength == 0)
+      {
+         // current buffer sent : continue with the next segment, if any
+         if (Payload->usSegmentsCount == 0)
+            break;
+
+         Payload->pszData = Payload->pSegments->pszData;
+         Payload->usLength = Payload->pSegments->usLength;
+         ++Payload->pSegments;
+         --Payload->usSegmentsCount;
+         continue;
+      }
+
+      size_t usCopySize = (Payload->usLength < usCurlSize - usCopiedSize) ?
+         Payload->usLength : usCurlSize - usCopiedSize;
+
+      /** copy data to buffer */
+      std::memcpy(pszCurlData + usCopiedSize, Payload->pszData, usCopySize);
+
+      // decrement length and increment data pointer
+      Payload->usLength -= usCopySize; // remaining bytes to be sent
+      Payload->pszData += usCopySize;  // next byte to the chunk that will be sent
+      usCopiedSize += usCopySize;
+   }
+
+   /** return copied size */
+   return usCopiedSize;
+}
+
+/**
+* @brief returns the number of bytes left to upload (current buffer and next segments)
+*/
+const size_t CHTTPClient::UploadObject::GetTotalLength() const
+{
+   size_t usTotalLength = usLength;
+   for (size_t i = 0; i < usSegmentsCount; ++i)
+      usTotalLength += pSegments[i].usLength;
+
+   return usTotalLength;
+}
+
+/**
+* @brief returns the size of the body to announce to libcurl, -1 if it isn't known
+* (streamed body of unknown length, sent with chunked transfer encoding)
+*/
+const curl_off_t CHTTPClient::UploadObject::GetUploadSize() const
+{
+   if (pfnProducer != nullptr)
+      return iStreamLength;
+
+   return static_cast<curl_off_t>(GetTotalLength());
+}
+
+/**
+* @brief write callback function for libcurl used by streamed responses
+* stores the received block in the response stream, or pauses the transfer if the stream
+* is full : libcurl delivers the same block again once the transfer is resumed
+*
+* @param userdata pointer to the response stream
+*
+* @return (size * nmemb) or CURL_WRITEFUNC_PAUSE
+*/
+size_t CHTTPClient::StreamWriteCallback(void* pCurlData, size_t usBlockCount, size_t usBlockSize, void* pUserData)
+{
+   CHTTPResponseStream* pStream = reinterpret_cast<CHTTPResponseStream*>(pUserData);
+
+   const size_t usSize = usBlockCount * usBlockSize;
+   if (!pStream->Write(reinterpret_cast<const char*>(pCurlData), usSize))
+      return CURL_WRITEFUNC_PAUSE;
+
+   return usSize;
+}
+
+/**
+* @brief write callback function for libcurl used by JSON streamed responses
+* feeds the received block to the JSON parser
+*
+* @param userdata pointer to the JSON parser
+*
+* @return (size * nmemb), 0 to abort the transfer if the parsing failed
+*/
+size_t CHTTPClient::JsonWriteCallback(void* pCurlData, size_t usBlockCount, size_t usBlockSize, void* pUserData)
+{
+   CHTTPJsonStream* pParser = reinterpret_cast<CHTTPJsonStream*>(pUserData);
+
+   const size_t usSize = usBlockCount * usBlockSize;
+   if (!pParser->Parse(reinterpret_cast<const char*>(pCurlData), usSize))
+      return 0;
+
+   return usSize;
+}
+
+/**
+* @brief write callback function for libcurl used by line-delimited responses
+* splits the received block into lines
+*
+* @param userdata pointer to the line reader
+*
+* @return (size * nmemb), 0 to abort the transfer if the reader was stopped
+*/
+size_t CHTTPClient::LineWriteCallback(void* pCurlData, size_t usBlockCount, size_t usBlockSize, void* pUserData)
+{
+   CHTTPLineReader* pReader = reinterpret_cast<CHTTPLineReader*>(pUserData);
+
+   const size_t usSize = usBlockCount * usBlockSize;
+   if (!pReader->Parse(reinterpret_cast<const char*>(pCurlData), usSize))
+      return 0;
+
+   return usSize;
+}
+
+/**
+* @brief write callback function for libcurl used by Server-Sent Events streams
+* the response is checked on its first block (status 200 and text/event-stream), the
+* blocks of any other response are not parsed
+*
+* @param userdata pointer to the connection's state
+*
+* @return (size * nmemb), 0 to abort the transfer if the reader was stopped
+*/
+size_t CHTTPClient::EventWriteCallback(void* pCurlData, size_t usBlockCount, size_t usBlockSize, void* pUserData)
+{
+   EventConnection* pConnection = reinterpret_cast<EventConnection*>(pUserData);
+
+   const size_t usSize = usBlockCount * usBlockSize;
+   if (!pConnection->bChecked)
+   {
+      pConnection->bChecked = true;
+
+      long lHttpCode = 0;
+      char* pszContentType = nullptr;
+      curl_easy_getinfo(pConnection->pCurl, CURLINFO_RESPONSE_CODE, &lHttpCode);
+      curl_easy_getinfo(pConnection->pCurl, CURLINFO_CONTENT_TYPE, &pszContentType);
+
+      pConnection->bValid = lHttpCode == 200 && pszContentType != nullptr &&
+         CHTTPUrlBuilder::StartsWithNoCase(pszContentType, "text/event-stream");
+   }
+
+   if (!pConnection->bValid)
+      return usSize;
+
+   if (!pConnection->pReader->Parse(reinterpret_cast<const char*>(pCurlData), usSize))
+      return 0;
 
-                                    /** return copied size */
-   return usCopySize;
+   return usSize;
 }
 
 // CURL DEBUG INFO CALLBACKS
@@ -13,7 +13,9 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstddef>         // std::size_t
+#include <cstdint>
 #include <cstdio>          // snprintf
 #include <cstdlib>
 #include <cstring>         // strerror, strlen, memcpy, strcpy
@@ -31,10 +33,29 @@
 #include <string>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>   // std::declval, std::move
 #include <vector>
 
 #include "CurlHandle.h"
+#include "HTTPAsyncLogger.h"
+#include "HTTPCertificateStore.h"
+#include "HTTPConnectionPool.h"
+#include "HTTPDnsCache.h"
+#include "HTTPHeaderSet.h"
+#include "HTTPJsonStream.h"
+#include "HTTPLocalAddressPool.h"
+#include "HTTPMultipartForm.h"
+#include "HTTPProxyPool.h"
+#include "HTTPResponseStream.h"
+#include "HTTPSocketProfile.h"
+#include "HTTPStreamReader.h"
+#include "HTTPTlsSessionCache.h"
+#include "HTTPUrlBuilder.h"
+
+class CHTTPTransferEngine;
 
 class CHTTPClient
 {
@@ -45,7 +66,8 @@ public:
    typedef std::unordered_map<std::string, std::string>              HeadersMap;
    typedef std::vector<char> ByteBuffer;
 
-   /* This struct represents the form information to send on POST Form requests */
+   /* This struct represents the form information to send on POST Form requests
+    * (built on the deprecated curl_formadd API, see CHTTPMultipartForm) */
    struct PostFormInfo
    {
       PostFormInfo();
@@ -91,6 +113,159 @@ public:
       ALL_FLAGS = 0xFF
    };
 
+   /* Non-owning view of a contiguous request body : it can be built from a pointer and a
+    * length or from any container with data() and size() (std::string, std::vector,
+    * std::array, std::string_view...), so the body is sent without being copied into a
+    * std::string first. The viewed data must remain valid until the request returns. */
+   struct BodyView
+   {
+      BodyView() : pszData(nullptr), usLength(0) {}
+      BodyView(const void* pData, const size_t usDataLength) :
+         pszData(static_cast<const char*>(pData)),
+         usLength(usDataLength)
+      {}
+      template <class Container,
+                class = decltype(std::declval<const Container&>().data()),
+                class = decltype(std::declval<const Container&>().size())>
+      BodyView(const Container& Data) :
+         pszData(reinterpret_cast<const char*>(Data.data())),
+         usLength(Data.size() * sizeof(*Data.data()))
+      {
+         static_assert(std::is_trivially_copyable<typename std::remove_reference<decltype(*Data.data())>::type>::value,
+                       "the elements of a body must be trivially copyable");
+      }
+
+      const char* pszData;
+      size_t usLength;
+   };
+
+   typedef std::vector<BodyView> BodySegments;
+
+   /* Producer of a streamed request body : it writes at most usSize bytes in pszBuffer and
+    * returns the number of bytes written, 0 once the body is complete, PRODUCER_PAUSE when
+    * no data is ready yet (the upload is paused until ResumeUpload() is called) or
+    * PRODUCER_ABORT to abort the request. It is called from the thread performing the request. */
+   typedef std::function<size_t(char* pszBuffer, size_t usSize)> ProducerFnCallback;
+   static constexpr size_t PRODUCER_PAUSE = CURL_READFUNC_PAUSE;
+   static constexpr size_t PRODUCER_ABORT = CURL_READFUNC_ABORT;
+
+   // libcurl's default buffer sizes and the largest sizes picked by the adaptive buffers
+   static constexpr long DEFAULT_RECEIVE_BUFFER = CURL_MAX_WRITE_SIZE;
+   static constexpr long DEFAULT_UPLOAD_BUFFER = 64 * 1024;
+   static constexpr long MAX_ADAPTIVE_RECEIVE_BUFFER = 1024 * 1024;
+   static constexpr long MAX_ADAPTIVE_UPLOAD_BUFFER = 2 * 1024 * 1024;
+
+   /* Request body produced on demand, so it doesn't have to be held in memory. When its
+    * length isn't known (-1), it is sent with "Transfer-Encoding: chunked". */
+   struct BodyStream
+   {
+      explicit BodyStream(const ProducerFnCallback& fnBodyProducer, const curl_off_t iBodyLength = -1) :
+         fnProducer(fnBodyProducer),
+         iLength(iBodyLength)
+      {}
+      ProducerFnCallback fnProducer;
+      curl_off_t iLength;
+   };
+
+   // payload to upload on POST requests.
+   struct UploadObject
+   {
+      UploadObject() : pszData(nullptr), usLength(0), pSegments(nullptr), usSegmentsCount(0),
+                       pfnProducer(nullptr), iStreamLength(-1), pMime(nullptr) {}
+      const size_t GetTotalLength() const;
+      const curl_off_t GetUploadSize() const;
+      const char* pszData; // data to upload
+      size_t usLength; // length of the data to upload
+      // scatter-gather : buffers sent in sequence once the data above is sent
+      const BodyView* pSegments;
+      size_t usSegmentsCount;
+      // streamed body : when set, the producer fills libcurl's buffer instead of the data above
+      const ProducerFnCallback* pfnProducer;
+      curl_off_t iStreamLength; // -1 if unknown
+      // multipart body : sent instead of the data above
+      curl_mime* pMime;
+   };
+
+   /* setup of the connection of the last request, in microseconds : the TCP and TLS
+    * durations are 0 when an open connection was reused (lNewConnections == 0) */
+   struct ConnectTimings
+   {
+      ConnectTimings() : llResolveUs(0), llConnectUs(0), llTlsUs(0), llSetupUs(0), llFirstByteUs(0),
+                         lNewConnections(0) {}
+      long long llResolveUs;
+      long long llConnectUs;     // TCP handshake
+      long long llTlsUs;         // TLS handshake
+      long long llSetupUs;       // from the start until the request could be sent
+      long long llFirstByteUs;   // from the request being sent until the first response byte
+      long      lNewConnections;
+   };
+
+   enum RestMethod
+   {
+      REST_HEAD,
+      REST_GET,
+      REST_DELETE,
+      REST_POST,
+      REST_PUT,
+      REST_PATCH,
+      REST_OPTIONS
+   };
+
+   /* A REST request built once and executed many times on a session (see Execute) : as long
+    * as the session's handle isn't used by another request, an execution only performs the
+    * transfer, the URL, the headers and the options set at the first execution are kept.
+    * The response's buffers are reused between executions.
+    *
+    * The client's settings (proxy, timeout, SSL...) are those active at the first execution,
+    * changing them with the client's setters configures the handle again on the next one. */
+   class PreparedRequest
+   {
+   public:
+      /* iTimeout in seconds, -1 to use the client's timeout */
+      PreparedRequest(const RestMethod eMethod, const std::string& strUrl,
+                      const HeadersMap& Headers = HeadersMap(),
+                      const std::string& strBody = std::string(),
+                      const int iTimeout = -1);
+
+      // copy constructor and assignment operator are disabled (the handle refers to the object)
+      PreparedRequest(const PreparedRequest& Copy) = delete;
+      PreparedRequest& operator=(const PreparedRequest& Copy) = delete;
+
+      /* sent on POST, PUT and PATCH requests, the next execution configures the handle again */
+      void SetBody(const std::string& strBody);
+
+      /* the request is sent through this Unix domain socket instead of the session's one
+       * (see CHTTPClient::SetUnixSocketPath), empty to use the session's one */
+      void SetUnixSocketPath(const std::string& strPath, const bool bAbstract = false);
+
+      /* the new connections of the request are tuned with this profile instead of the
+       * session's one, nullptr to use the session's one */
+      void SetSocketProfile(std::shared_ptr<const CHTTPSocketProfile> pSocketProfile);
+
+      inline const RestMethod GetMethod() const { return m_eMethod; }
+      inline const std::string& GetUrl() const { return m_strUrl; }
+      inline const std::string& GetBody() const { return m_strBody; }
+      inline const std::string& GetUnixSocketPath() const { return m_strUnixSocketPath; }
+      inline const HttpResponse& GetResponse() const { return m_Response; }
+
+   protected:
+      friend class CHTTPClient;
+
+      static const uint64_t NewId();
+
+      uint64_t     m_ulId;
+      RestMethod   m_eMethod;
+      std::string  m_strUrl;
+      HeadersMap   m_Headers;
+      std::string  m_strBody;
+      int          m_iTimeout;
+      std::string  m_strUnixSocketPath;
+      bool         m_bAbstractUnixSocket;
+      std::shared_ptr<const CHTTPSocketProfile> m_pSocketProfile;
+      UploadObject m_Payload;
+      HttpResponse m_Response;
+   };
+
    /* Please provide your logger thread-safe routine, otherwise, you can turn off
    * error log messages printing by not using the flag ALL_FLAGS or ENABLE_LOG */
    explicit CHTTPClient(LogFnCallback oLogger);
@@ -103,9 +278,24 @@ public:
    // Setters - Getters (for unit tests)
    /*inline*/ void SetProgressFnCallback(void* pOwner, const ProgressFnCallback& fnCallback);
    /*inline*/ void SetProxy(const std::string& strProxy);
-   inline void SetTimeout(const int& iTimeout) { m_iCurlTimeout = iTimeout; }
-   inline void SetNoSignal(const bool& bNoSignal) { m_bNoSignal = bNoSignal; }
-   inline void SetHTTPS(const bool& bEnableHTTPS) { m_bHTTPS = bEnableHTTPS; }
+   inline void SetTimeout(const int& iTimeout) { m_iCurlTimeout = iTimeout; m_ulPreparedId = 0; }
+   inline void SetNoSignal(const bool& bNoSignal) { m_bNoSignal = bNoSignal; m_ulPreparedId = 0; }
+   inline void SetHTTPS(const bool& bEnableHTTPS) { m_bHTTPS = bEnableHTTPS; m_ulPreparedId = 0; }
+   /* opt-in : the GET and HEAD requests are sent in the SYN of a new connection (TCP Fast Open)
+    * and in the TLS 1.3 early data of a resumed session, saving the handshakes' round trips.
+    * Such data can be replayed by the network : the other methods never use them.
+    * TCP Fast Open is only used when libcurl reuses its connections (see IsFastOpenReusable),
+    * otherwise each request would pay a new handshake instead of reusing the connection. */
+   inline void SetFastOpen(const bool& bFastOpen) { m_bFastOpen = bFastOpen; m_ulPreparedId = 0; }
+   /* the requests are sent through this Unix domain socket (e.g. a local sidecar) instead of
+    * a TCP connection to the URL's host, which is still used for the Host header. bAbstract :
+    * the path is a name in the abstract namespace (Linux). Empty to connect with TCP again. */
+   inline void SetUnixSocketPath(const std::string& strPath, const bool bAbstract = false)
+   {
+      m_strUnixSocketPath = strPath;
+      m_bAbstractUnixSocket = bAbstract;
+      m_ulPreparedId = 0;
+   }
    inline auto GetProgressFnCallback() const
    {
       return m_fnProgressCallback.target<int(*)(void*, double, double, double, double)>();
@@ -114,10 +304,130 @@ public:
    inline const std::string& GetProxy() const { return m_strProxy; }
    inline const int GetTimeout() const { return m_iCurlTimeout; }
    inline const bool GetNoSignal() const { return m_bNoSignal; }
+   inline const bool GetFastOpen() const { return m_bFastOpen; }
+   inline const std::string& GetUnixSocketPath() const { return m_strUnixSocketPath; }
+   inline const bool GetAbstractUnixSocket() const { return m_bAbstractUnixSocket; }
    inline const std::string& GetURL()      const { return m_strURL; }
    inline const unsigned char GetSettingsFlags() const { return m_eSettingsFlags; }
    inline const bool GetHTTPS() const { return m_bHTTPS; }
 
+   /* log messages are handed over to this logger (when it is running) instead of being
+    * formatted and printed synchronously. Pass nullptr to log synchronously again. */
+   inline void SetAsyncLogger(CHTTPAsyncLogger* pAsyncLogger) { m_pAsyncLogger = pAsyncLogger; }
+   inline CHTTPAsyncLogger* GetAsyncLogger() const { return m_pAsyncLogger; }
+
+   /* the hosts of the requests are resolved by this cache (e.g. CHTTPDnsCache::Global())
+    * instead of libcurl's per-handle cache, it isn't used through a proxy. Pass nullptr to
+    * let libcurl resolve them again. */
+   inline void SetDnsCache(CHTTPDnsCache* pDnsCache) { m_pDnsCache = pDnsCache; m_ulPreparedId = 0; }
+   inline CHTTPDnsCache* GetDnsCache() const { return m_pDnsCache; }
+
+   /* time spent resolving the host of the last request, in microseconds : the lookup in the
+    * DNS cache if it answered, libcurl's name resolution otherwise */
+   inline const long long GetResolveTime() const { return m_llResolveTimeUs; }
+
+   /* sizes of the buffers libcurl receives (CURLOPT_BUFFERSIZE) and sends
+    * (CURLOPT_UPLOAD_BUFFERSIZE) the bodies with, 0 for libcurl's defaults. With adaptive
+    * buffers, they are the largest sizes picked (0 : MAX_ADAPTIVE_*_BUFFER). */
+   inline void SetBufferSizes(const long lReceiveBuffer, const long lUploadBuffer)
+   {
+      m_lReceiveBuffer = lReceiveBuffer;
+      m_lUploadBuffer = lUploadBuffer;
+      m_ulPreparedId = 0;
+   }
+   inline const long GetReceiveBufferSize() const { return m_lReceiveBuffer; }
+   inline const long GetUploadBufferSize() const { return m_lUploadBuffer; }
+
+   /* the buffer sizes of a transfer are picked from the size and the throughput of the
+    * previous transfers to the same host, the file transfers start with large buffers */
+   inline void SetAdaptiveBuffers(const bool bAdaptive) { m_bAdaptiveBuffers = bAdaptive; m_ulPreparedId = 0; }
+   inline const bool GetAdaptiveBuffers() const { return m_bAdaptiveBuffers; }
+
+   static const long AdaptBufferSize(const long long llBytes, const long long llBytesPerSec, const long lMaxSize);
+
+   // connection setup of the last request (e.g. to measure the savings of SetFastOpen)
+   inline const ConnectTimings& GetConnectTimings() const { return m_ConnectTimings; }
+
+   static const bool IsFastOpenReusable();
+
+   /* the session takes its connections from this pool and parks them there, so they are
+    * reused by the other sessions of the pool. Pass nullptr to use the session's own
+    * connections again. */
+   void SetConnectionPool(CHTTPConnectionPool* pConnectionPool);
+   inline CHTTPConnectionPool* GetConnectionPool() const { return m_pConnectionPool; }
+
+   /* the TLS sessions negotiated by the session are recorded in this cache and offered
+    * back to the servers, so the cache can carry them over a restart (see
+    * CHTTPTlsSessionCache::Export). Pass nullptr to remove it. */
+   inline void SetTlsSessionCache(CHTTPTlsSessionCache* pTlsSessionCache)
+   {
+      m_pTlsSessionCache = pTlsSessionCache;
+      m_ulPreparedId = 0;
+   }
+   inline CHTTPTlsSessionCache* GetTlsSessionCache() const { return m_pTlsSessionCache; }
+
+   /* establishes uConnectionsPerHost connections (TLS handshake included) to the host of
+    * each URL in parallel, with the session's settings, and parks them in the session's
+    * connection pool for the next requests */
+   CHTTPConnectionPool::PrewarmReport Prewarm(const std::vector<std::string>& vecUrls,
+                                              const unsigned uConnectionsPerHost);
+
+   /* the sockets of the new connections are tuned with this profile (e.g.
+    * CHTTPSocketProfile::LowLatency()), the file transfers (DownloadFile, UploadForm) use
+    * the file profile if one is set (e.g. CHTTPSocketProfile::Bulk()). A profile can be
+    * shared by several clients. Pass nullptr to keep libcurl's defaults. */
+   inline void SetSocketProfile(std::shared_ptr<const CHTTPSocketProfile> pSocketProfile)
+   {
+      m_pSocketProfile = std::move(pSocketProfile);
+      m_ulPreparedId = 0;
+   }
+   inline const std::shared_ptr<const CHTTPSocketProfile>& GetSocketProfile() const { return m_pSocketProfile; }
+   inline void SetFileSocketProfile(std::shared_ptr<const CHTTPSocketProfile> pSocketProfile)
+   {
+      m_pFileSocketProfile = std::move(pSocketProfile);
+   }
+   inline const std::shared_ptr<const CHTTPSocketProfile>& GetFileSocketProfile() const
+   {
+      return m_pFileSocketProfile;
+   }
+
+   /* the transfers are bound to the addresses of the pool in turn (see
+    * CHTTPLocalAddressPool), the pool can be shared by several clients. Not used with a Unix
+    * domain socket. Pass nullptr to use the default route. */
+   inline void SetLocalAddressPool(CHTTPLocalAddressPool* pLocalAddressPool)
+   {
+      m_pLocalAddressPool = pLocalAddressPool;
+      m_ulPreparedId = 0;
+   }
+   inline CHTTPLocalAddressPool* GetLocalAddressPool() const { return m_pLocalAddressPool; }
+
+   /* the transfers go through the proxies of the pool (see CHTTPProxyPool) instead of the
+    * proxy set with SetProxy, a request that can't reach its proxy is sent again through
+    * the next one. The pool can be shared by several clients. Pass nullptr to remove it. */
+   inline void SetProxyPool(CHTTPProxyPool* pProxyPool) { m_pProxyPool = pProxyPool; m_ulPreparedId = 0; }
+   inline CHTTPProxyPool* GetProxyPool() const { return m_pProxyPool; }
+
+   /* whether the requests go through a tunnel (CONNECT) established with an HTTP proxy, or
+    * are forwarded by the proxy (cheaper, but the proxy sees the requests), per scheme of
+    * the requested URL. Both are tunnelled by default. */
+   inline void SetProxyTunnel(const bool bTunnelHttp, const bool bTunnelHttps = true)
+   {
+      m_bTunnelHttp = bTunnelHttp;
+      m_bTunnelHttps = bTunnelHttps;
+      m_ulPreparedId = 0;
+   }
+   inline const bool GetProxyTunnelHttp() const { return m_bTunnelHttp; }
+   inline const bool GetProxyTunnelHttps() const { return m_bTunnelHttps; }
+
+   /* headers sent on every REST request, the headers passed to a request are layered on
+    * top of them. The set can be shared by several clients. Pass nullptr to remove it. */
+   inline void SetHeaderSet(std::shared_ptr<const CHTTPHeaderSet> pHeaderSet)
+   {
+      m_pHeaderSet = std::move(pHeaderSet);
+      m_ulPreparedId = 0;
+   }
+   inline const std::shared_ptr<const CHTTPHeaderSet>& GetHeaderSet() const { return m_pHeaderSet; }
+
    // Session
    const bool InitSession(const bool& bHTTPS = false,
                           const SettingsFlag& SettingsFlags = ALL_FLAGS);
@@ -139,6 +449,10 @@ public:
                          const PostFormInfo& data,
                          long& lHTTPStatusCode);
 
+   const bool UploadForm(const std::string& strURL,
+                         const CHTTPMultipartForm& Form,
+                         long& lHTTPStatusCode);
+
    inline void AddHeader(const std::string& strHeader)
    {
       m_pHeaderlist = curl_slist_append(m_pHeaderlist, strHeader.c_str());
@@ -154,18 +468,102 @@ public:
             const std::string& strPutData, HttpResponse& Response);
    const bool Put(const std::string& strUrl, const HeadersMap& Headers,
             const ByteBuffer& Data, HttpResponse& Response);
-   
+   const bool Patch(const std::string& strUrl, const HeadersMap& Headers,
+            const std::string& strPatchData, HttpResponse& Response);
+   const bool Options(const std::string& strUrl, const HeadersMap& Headers, HttpResponse& Response);
+
+   // REST requests sending a body view (no copy of the body)
+   const bool Post(const std::string& strUrl, const HeadersMap& Headers,
+             const BodyView& PostData, HttpResponse& Response);
+   const bool Put(const std::string& strUrl, const HeadersMap& Headers,
+            const BodyView& PutData, HttpResponse& Response);
+   const bool Patch(const std::string& strUrl, const HeadersMap& Headers,
+            const BodyView& PatchData, HttpResponse& Response);
+
+   // REST requests sending a body made of several buffers (no concatenation)
+   const bool Post(const std::string& strUrl, const HeadersMap& Headers,
+             const BodySegments& PostData, HttpResponse& Response);
+   const bool Put(const std::string& strUrl, const HeadersMap& Headers,
+            const BodySegments& PutData, HttpResponse& Response);
+   const bool Patch(const std::string& strUrl, const HeadersMap& Headers,
+            const BodySegments& PatchData, HttpResponse& Response);
+
+   // REST requests sending a body produced on demand (streamed upload)
+   const bool Post(const std::string& strUrl, const HeadersMap& Headers,
+             const BodyStream& PostData, HttpResponse& Response);
+   const bool Put(const std::string& strUrl, const HeadersMap& Headers,
+            const BodyStream& PutData, HttpResponse& Response);
+   const bool Patch(const std::string& strUrl, const HeadersMap& Headers,
+            const BodyStream& PatchData, HttpResponse& Response);
+
+   // POST request sending a multipart/form-data body (see CHTTPMultipartForm)
+   const bool Post(const std::string& strUrl, const HeadersMap& Headers,
+             const CHTTPMultipartForm& Form, HttpResponse& Response);
+
+   /* resumes a streamed upload paused by its producer (PRODUCER_PAUSE), can be called from
+    * any thread */
+   inline void ResumeUpload() { ResumeTransfer(); }
+
+   /* GET request receiving its body in a bounded stream read by a consumer (see
+    * CHTTPResponseStream) : Response gets the code and the headers, its body stays empty */
+   const bool Get(const std::string& strUrl, const HeadersMap& Headers,
+                  CHTTPResponseStream& Body, HttpResponse& Response);
+
+   /* GET request whose JSON body is parsed while it is received (see CHTTPJsonStream) :
+    * Response gets the code and the headers, its body stays empty */
+   const bool Get(const std::string& strUrl, const HeadersMap& Headers,
+                  CHTTPJsonStream& Body, HttpResponse& Response);
+
+   /* GET request whose body is split into lines while it is received (e.g. NDJSON, see
+    * CHTTPLineReader) : Response gets the code and the headers, its body stays empty */
+   const bool Get(const std::string& strUrl, const HeadersMap& Headers,
+                  CHTTPLineReader& Body, HttpResponse& Response);
+
+   /* listens to a Server-Sent Events stream (see CHTTPEventReader) : the connection is
+    * re-established after the retry delay, with the Last-Event-ID header, whenever it is
+    * lost. uMaxReconnects : reconnections in a row without receiving an event (0 : no limit) */
+   const bool Subscribe(const std::string& strUrl, const HeadersMap& Headers,
+                        CHTTPEventReader& Events, HttpResponse& Response,
+                        const unsigned uMaxReconnects = 0);
+
+   /* REST requests returning the response by value : its code is -1 on failure. Its body
+    * buffer comes from the last response given back with RecycleResponse, if any. */
+   HttpResponse Head(const std::string& strUrl, const HeadersMap& Headers);
+   HttpResponse Get(const std::string& strUrl, const HeadersMap& Headers);
+   HttpResponse Del(const std::string& strUrl, const HeadersMap& Headers);
+   HttpResponse Post(const std::string& strUrl, const HeadersMap& Headers, const BodyView& PostData);
+   HttpResponse Put(const std::string& strUrl, const HeadersMap& Headers, const BodyView& PutData);
+   HttpResponse Patch(const std::string& strUrl, const HeadersMap& Headers, const BodyView& PatchData);
+   HttpResponse Options(const std::string& strUrl, const HeadersMap& Headers);
+
+   /* gives back a response that is no longer used, its body buffer is reused by the next
+    * request returning its response by value */
+   void RecycleResponse(HttpResponse&& Response);
+
+   // Prepared REST requests
+   const bool Execute(PreparedRequest& Request);
+
    // SSL certs
-   static const std::string& GetCertificateFile() { return s_strCertificationAuthorityFile; }
-   static void SetCertificateFile(const std::string& strPath) { s_strCertificationAuthorityFile = strPath; }
+   static std::string GetCertificateFile();
+   static void SetCertificateFile(const std::string& strPath);
+
+   /* the CA bundle and the client certificate are taken from this store, loaded once in
+    * memory for all the sessions, instead of being read from the files on each request.
+    * The certificates missing in the store are taken from the files. Pass nullptr to remove it. */
+   inline void SetCertificateStore(CHTTPCertificateStore* pCertificateStore)
+   {
+      m_pCertificateStore = pCertificateStore;
+      m_ulPreparedId = 0;
+   }
+   inline CHTTPCertificateStore* GetCertificateStore() const { return m_pCertificateStore; }
 
-   void SetSSLCertFile(const std::string& strPath) { m_strSSLCertFile = strPath; }
+   void SetSSLCertFile(const std::string& strPath) { m_strSSLCertFile = strPath; m_ulPreparedId = 0; }
    const std::string& GetSSLCertFile() const { return m_strSSLCertFile; }
 
-   void SetSSLKeyFile(const std::string& strPath) { m_strSSLKeyFile = strPath; }
+   void SetSSLKeyFile(const std::string& strPath) { m_strSSLKeyFile = strPath; m_ulPreparedId = 0; }
    const std::string& GetSSLKeyFile() const { return m_strSSLKeyFile; }
 
-   void SetSSLKeyPassword(const std::string& strPwd) { m_strSSLKeyPwd = strPwd; }
+   void SetSSLKeyPassword(const std::string& strPwd) { m_strSSLKeyPwd = strPwd; m_ulPreparedId = 0; }
    const std::string& GetSSLKeyPwd() const { return m_strSSLKeyPwd; }
 
 #ifdef DEBUG_CURL
@@ -178,20 +576,55 @@ public:
 #endif
 
 protected:
-   // payload to upload on POST requests.
-   struct UploadObject
-   {
-      UploadObject() : pszData(nullptr), usLength(0) {}
-      const char* pszData; // data to upload
-      size_t usLength; // length of the data to upload
-   };
-
    /* common operations are performed here */
    inline const CURLcode Perform();
+   const CURLcode PerformPausable();
+   const CURLcode FailOver(CURLcode eResult);
+   void ResumeTransfer();
+   const CURLcode PrepareTransfer();
+   void FinishTransfer(const CURLcode eResult = CURLE_OK);
+   void ApplyDnsCache();
+   void ApplyCertificates();
+   void ApplyFastOpen();
+   void ApplyBufferSizes();
+   void RecordBufferSizes();
+   static void SetUnixSocket(CURL* pCurl, const std::string& strPath, const bool bAbstract);
    inline void UpdateURL(const std::string& strURL);
-   inline const bool InitRestRequest(const std::string& strUrl, const HeadersMap& Headers,
-                               HttpResponse& Response);
-   inline const bool PostRestRequest(const CURLcode ePerformCode, HttpResponse& Response);
+   inline void ResetSession();
+   const bool InitRestRequest(const std::string& strUrl, const HeadersMap& Headers,
+                              HttpResponse& Response);
+   const bool PostRestRequest(const CURLcode ePerformCode, HttpResponse& Response);
+   void SetRestMethod(const RestMethod eMethod, const std::string& strBody, UploadObject& Payload);
+
+   // REST requests core : each method is a policy with a constexpr table of the options
+   // it sets and the source of the body it sends (see HTTPClient.cpp)
+   struct CurlOption;
+   struct NoBody;
+   struct PostFieldsBody;
+   struct ReadCallbackBody;
+   struct ReadCallbackPostBody;
+   struct MimePostBody;
+   struct HeadMethod;
+   struct GetMethod;
+   struct DeleteMethod;
+   struct PostMethod;
+   struct PutMethod;
+   struct PatchMethod;
+   struct OptionsMethod;
+
+   template <class Method, class BodySource = typename Method::BodySource>
+   const bool RestRequest(const std::string& strUrl, const HeadersMap& Headers,
+                          UploadObject& Payload, HttpResponse& Response);
+   template <class Method, class BodySource = typename Method::BodySource>
+   HttpResponse RestRequest(const std::string& strUrl, const HeadersMap& Headers, const BodyView& Body);
+   template <class Method, class BodySource = typename Method::BodySource>
+   void SetRestOptions(UploadObject& Payload);
+   template <class Method, class BodySource>
+   const bool StreamRequest(const std::string& strUrl, const HeadersMap& Headers,
+                            const BodyStream& Body, HttpResponse& Response);
+   template <size_t N>
+   static void SetCurlOptions(CURL* pCurl, const CurlOption (&Options)[N]);
+   void BuildRestHeaders(const HeadersMap& Headers);
 
    // Curl callbacks
    static size_t WriteInStringCallback(void* ptr, size_t size, size_t nmemb, void* data);
@@ -202,7 +635,16 @@ protected:
    static size_t RestWriteCallback(void* ptr, size_t size, size_t nmemb, void* userdata);
    static size_t RestHeaderCallback(void* ptr, size_t size, size_t nmemb, void* userdata);
    static size_t RestReadCallback(void* ptr, size_t size, size_t nmemb, void* userdata);
+   static size_t StreamWriteCallback(void* ptr, size_t size, size_t nmemb, void* userdata);
+   static size_t JsonWriteCallback(void* ptr, size_t size, size_t nmemb, void* userdata);
+   static size_t LineWriteCallback(void* ptr, size_t size, size_t nmemb, void* userdata);
+   static size_t EventWriteCallback(void* ptr, size_t size, size_t nmemb, void* userdata);
    
+   // Log Helpers
+   void Log(const CHTTPAsyncLogger::LogEvent eEvent, const char* pszUrl = nullptr,
+            const CURLcode eCode = CURLE_OK, const long lStatus = 0,
+            const char* pszLocalFile = nullptr) const;
+
    // String Helpers
    static std::string StringFormat(const std::string strFormat, ...);
    static inline void TrimSpaces(std::string& str);
@@ -216,15 +658,79 @@ protected:
 
    std::string          m_strURL;
    std::string          m_strProxy;
+   bool                 m_bTunnelHttp;
+   bool                 m_bTunnelHttps;
+   std::string          m_strUnixSocketPath;
+   bool                 m_bAbstractUnixSocket;
 
    bool                 m_bNoSignal;
+   bool                 m_bFastOpen;
    bool                 m_bHTTPS;
    SettingsFlag         m_eSettingsFlags;
 
    struct curl_slist*    m_pHeaderlist;
 
-   // SSL
-   static std::string   s_strCertificationAuthorityFile;
+   // REST requests headers : nodes pointing to the lines of m_pHeaderlist, of the
+   // per-request headers and of the header set. Buffers are kept between requests.
+   std::shared_ptr<const CHTTPHeaderSet> m_pHeaderSet;
+   std::vector<std::string>              m_vecHeaderLines;
+   std::vector<struct curl_slist>        m_vecHeaderNodes;
+   struct curl_slist*                    m_pRestHeaders;
+
+   // body buffer of a recycled response
+   std::string                           m_strRecycledBody;
+
+   // transfers that can be paused (streamed bodies) are performed on this multi handle,
+   // so the thread resuming them can wake up the thread performing them
+   CURLM*                                m_pPausableMulti;
+   bool                                  m_bPausableTransfer;
+   std::atomic<bool>                     m_bResumeTransfer;
+
+   CHTTPConnectionPool*                  m_pConnectionPool;
+
+   // socket tuning : the file profile is used while m_bFileTransfer is set
+   std::shared_ptr<const CHTTPSocketProfile> m_pSocketProfile;
+   std::shared_ptr<const CHTTPSocketProfile> m_pFileSocketProfile;
+   bool                                  m_bFileTransfer;
+
+   // buffers : the adaptive sizes are kept per "host:port" (a few hosts per session)
+   struct BufferSizes
+   {
+      long lReceive;
+      long lUpload;
+   };
+   long                                  m_lReceiveBuffer;
+   long                                  m_lUploadBuffer;
+   bool                                  m_bAdaptiveBuffers;
+   std::unordered_map<std::string, BufferSizes> m_mapBufferSizes;
+
+   // proxy of the pool the current transfer goes through
+   CHTTPProxyPool*                       m_pProxyPool;
+   size_t                                m_usProxy;
+
+   // address of the pool the current transfer is bound to
+   CHTTPLocalAddressPool*                m_pLocalAddressPool;
+   size_t                                m_usLocalAddress;
+   CHTTPTlsSessionCache*                 m_pTlsSessionCache;
+
+   // DNS cache : CURLOPT_RESOLVE list made of a single node pointing to the entry
+   CHTTPDnsCache*                        m_pDnsCache;
+   std::string                           m_strResolveEntry;
+   struct curl_slist                     m_ResolveNode;
+   long long                             m_llResolveTimeUs;   // -1 : resolved by libcurl
+   ConnectTimings                        m_ConnectTimings;
+
+   // id of the prepared request the handle is configured for (0 : none)
+   uint64_t                              m_ulPreparedId;
+
+   // SSL : the CA file is replaced as a whole (atomic_load/atomic_store) as it is shared
+   // by all the sessions, each replacement increments the generation
+   static std::shared_ptr<const std::string> s_pCertificationAuthorityFile;
+   static std::atomic<uint64_t>              s_ulCertificationAuthorityGeneration;
+   uint64_t                                  m_ulCertificationAuthorityGeneration; // given to the handle
+   CHTTPCertificateStore*                    m_pCertificateStore;
+   // certificates given to the handle, kept alive until the next request (blobs not copied)
+   std::shared_ptr<const CHTTPCertificateStore::Certificates> m_pCertificates;
    std::string          m_strSSLCertFile;
    std::string          m_strSSLKeyFile;
    std::string          m_strSSLKeyPwd;
@@ -239,8 +745,12 @@ protected:
 
    // Log printer callback
    LogFnCallback         m_oLog;
+   CHTTPAsyncLogger*     m_pAsyncLogger;
 
 private:
+   // drives sessions' handles through a curl multi handle
+   friend class CHTTPTransferEngine;
+
 #ifdef DEBUG_CURL
    static std::string s_strCurlTraceLogDirectory;
    mutable std::ofstream      m_ofFileCurlTrace;
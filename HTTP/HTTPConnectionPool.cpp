@@ -0,0 +1,53 @@
+/**
+* @file HTTPConnectionPool.cpp
+* @brief implementation of the shared connection pool
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPConnectionPool.h"
+
+/**
+ * @brief constructor of the pool
+ *
+ * @param [in] lMaxConnections maximum number of idle connections kept open
+ */
+CHTTPConnectionPool::CHTTPConnectionPool(const long lMaxConnections /* = 64 */) :
+   m_pShare(curl_share_init()),
+   m_lMaxConnections(lMaxConnections)
+{
+   if (m_pShare != nullptr)
+   {
+      curl_share_setopt(m_pShare, CURLSHOPT_LOCKFUNC, &CHTTPConnectionPool::LockCallback);
+      curl_share_setopt(m_pShare, CURLSHOPT_UNLOCKFUNC, &CHTTPConnectionPool::UnlockCallback);
+      curl_share_setopt(m_pShare, CURLSHOPT_USERDATA, this);
+      curl_share_setopt(m_pShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+      curl_share_setopt(m_pShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+      curl_share_setopt(m_pShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+   }
+}
+
+/**
+ * @brief destructor of the pool, closes its connections
+ */
+CHTTPConnectionPool::~CHTTPConnectionPool()
+{
+   if (m_pShare != nullptr)
+      curl_share_cleanup(m_pShare);
+}
+
+/**
+ * @brief lock callback of the share : a mutex per kind of shared data
+ */
+void CHTTPConnectionPool::LockCallback(CURL* /*pCurl*/, curl_lock_data eData, curl_lock_access /*eAccess*/,
+                                       void* pUserData)
+{
+   reinterpret_cast<CHTTPConnectionPool*>(pUserData)->m_arrLocks[eData].lock();
+}
+
+/**
+ * @brief unlock callback of the share
+ */
+void CHTTPConnectionPool::UnlockCallback(CURL* /*pCurl*/, curl_lock_data eData, void* pUserData)
+{
+   reinterpret_cast<CHTTPConnectionPool*>(pUserData)->m_arrLocks[eData].unlock();
+}
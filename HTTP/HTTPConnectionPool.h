@@ -0,0 +1,61 @@
+/*
+ * @file HTTPConnectionPool.h
+ * @brief connections shared by several sessions, which can be established in advance
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPCONNECTIONPOOL_H_
+#define INCLUDE_HTTPCONNECTIONPOOL_H_
+
+#include <cstddef>         // std::size_t
+#include <curl/curl.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Pool of connections (and of resolved addresses and TLS sessions) shared by the sessions
+ * attached to it (see CHTTPClient::SetConnectionPool) : a connection left open by a
+ * session's request is reused by the next request of any session to the same host, and a
+ * new connection resumes the TLS session of another one. The pool is thread-safe, the
+ * sessions using it may run in different threads.
+ *
+ * The pool keeps at most GetMaxConnections() idle connections, the oldest ones are closed
+ * beyond that. Connections can be established in advance (e.g. after a deploy, before the
+ * traffic comes) with CHTTPClient::Prewarm.
+ *
+ * The pool must outlive the sessions attached to it. */
+class CHTTPConnectionPool
+{
+public:
+   /* outcome of a CHTTPClient::Prewarm call */
+   struct PrewarmReport
+   {
+      PrewarmReport() : usRequested(0), usWarmed(0), llElapsedMs(0) {}
+      size_t              usRequested;      // connections requested
+      size_t              usWarmed;         // connections established and parked in the pool
+      std::vector<size_t> vecWarmedPerUrl;  // same order as the URLs
+      long long           llElapsedMs;
+   };
+
+   explicit CHTTPConnectionPool(const long lMaxConnections = 64);
+   virtual ~CHTTPConnectionPool();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPConnectionPool(const CHTTPConnectionPool& Copy) = delete;
+   CHTTPConnectionPool& operator=(const CHTTPConnectionPool& Copy) = delete;
+
+   inline CURLSH* GetShare() const { return m_pShare; }
+   inline const long GetMaxConnections() const { return m_lMaxConnections; }
+   inline void SetMaxConnections(const long lMaxConnections) { m_lMaxConnections = lMaxConnections; }
+
+protected:
+   static void LockCallback(CURL* pCurl, curl_lock_data eData, curl_lock_access eAccess, void* pUserData);
+   static void UnlockCallback(CURL* pCurl, curl_lock_data eData, void* pUserData);
+
+   CURLSH*    m_pShare;
+   long       m_lMaxConnections;
+   std::mutex m_arrLocks[CURL_LOCK_DATA_LAST];
+};
+
+#endif
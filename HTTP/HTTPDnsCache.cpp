@@ -0,0 +1,576 @@
+/**
+* @file HTTPDnsCache.cpp
+* @brief implementation of the process-wide DNS cache
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPDnsCache.h"
+
+#include <algorithm>
+#include <cctype>          // tolower, isdigit
+#include <cstdlib>         // strtol
+#include <cstring>         // memset
+#include <curl/curl.h>     // LIBCURL_VERSION_NUM
+#include <vector>
+
+#ifdef WINDOWS
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#endif
+
+namespace
+{
+// the background thread refreshes an entry once 80% of its TTL has elapsed
+inline std::chrono::steady_clock::duration RefreshDelay(const std::chrono::seconds& Ttl)
+{
+   return std::chrono::duration_cast<std::chrono::steady_clock::duration>(Ttl) * 4 / 5;
+}
+
+// a failed refresh is retried after a tenth of the TTL (at least one second)
+inline std::chrono::steady_clock::duration RetryDelay(const std::chrono::seconds& Ttl)
+{
+   return std::max<std::chrono::steady_clock::duration>(std::chrono::seconds(1), Ttl / 10);
+}
+}
+
+/**
+ * @brief constructor of the cache, the refresh thread is started with the first entry
+ *
+ * @param [in] lTtl lifetime of the resolved addresses in seconds
+ * @param [in] lIdleTimeout entries unused for this long (in seconds) are evicted
+ */
+CHTTPDnsCache::CHTTPDnsCache(const long lTtl /* = 60 */, const long lIdleTimeout /* = 300 */) :
+   m_Ttl(std::max(1L, lTtl)),
+   m_IdleTimeout(std::max(1L, lIdleTimeout)),
+   m_bStopping(false)
+{
+}
+
+/**
+ * @brief destructor of the cache, stops the refresh thread
+ */
+CHTTPDnsCache::~CHTTPDnsCache()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mtxEntries);
+      m_bStopping = true;
+   }
+   m_cvRefresh.notify_all();
+
+   if (m_RefreshThread.joinable())
+      m_RefreshThread.join();
+}
+
+/**
+ * @brief returns the cache shared by the whole process
+ */
+CHTTPDnsCache& CHTTPDnsCache::Global()
+{
+   static CHTTPDnsCache s_GlobalCache;
+   return s_GlobalCache;
+}
+
+/**
+ * @brief returns the addresses of the host of an URL, the host is resolved if it isn't
+ * in the cache (or if its entry expired)
+ *
+ * @param [in] strUrl URL of a request ("http://" or "https://")
+ * @param [out] strResolveEntry entry to pass to CURLOPT_RESOLVE ("host:port:addresses")
+ *
+ * @retval true   The addresses are known.
+ * @retval false  The URL has no host name to resolve (IP address, unknown scheme) or the
+ * host couldn't be resolved : libcurl must resolve it.
+ */
+const bool CHTTPDnsCache::Lookup(const std::string& strUrl, std::string& strResolveEntry)
+{
+   std::string strHost;
+   int iPort = 0;
+   if (!SplitUrl(strUrl, strHost, iPort))
+      return false;
+
+   const std::string strKey = MakeKey(strHost, iPort);
+
+   std::unique_lock<std::mutex> lock(m_mtxEntries);
+
+   auto itEntry = m_mapEntries.find(strKey);
+   const Clock::time_point tNow = Clock::now();
+   if (itEntry != m_mapEntries.end() && !itEntry->second.strAddresses.empty() &&
+       (itEntry->second.bPinned || tNow < itEntry->second.tExpiry))
+   {
+      ++m_Stats.usHits;
+   }
+   else
+   {
+      ++m_Stats.usMisses;
+      if (!ResolveEntry(strKey, strHost, iPort, lock))
+         return false;
+
+      itEntry = m_mapEntries.find(strKey);
+      if (itEntry == m_mapEntries.end() || itEntry->second.strAddresses.empty())
+         return false;
+   }
+
+   itEntry->second.tLastUse = tNow;
+
+   // entries with a '+' expire from the handle's own cache instead of being permanent
+#if LIBCURL_VERSION_NUM >= 0x074b00
+   strResolveEntry.assign(1, '+');
+#else
+   strResolveEntry.clear();
+#endif
+   strResolveEntry.append(strKey).append(1, ':').append(itEntry->second.strAddresses);
+
+   return true;
+}
+
+/**
+ * @brief resolves the host of an URL in the background (e.g. at startup), the entry is
+ * then refreshed as long as it is used
+ *
+ * @param [in] strUrl URL of a future request
+ */
+void CHTTPDnsCache::Prefetch(const std::string& strUrl)
+{
+   std::string strHost;
+   int iPort = 0;
+   if (!SplitUrl(strUrl, strHost, iPort))
+      return;
+
+   const std::string strKey = MakeKey(strHost, iPort);
+   {
+      std::lock_guard<std::mutex> lock(m_mtxEntries);
+
+      auto itEntry = m_mapEntries.find(strKey);
+      if (itEntry != m_mapEntries.end())
+         return;
+
+      Entry& NewEntry = m_mapEntries[strKey];
+      NewEntry.strHost = strHost;
+      NewEntry.iPort = iPort;
+      NewEntry.tRefresh = NewEntry.tLastUse = Clock::now();
+
+      StartRefreshThread();
+   }
+   m_cvRefresh.notify_all();
+}
+
+/**
+ * @brief pins the addresses of a host : they are used instead of resolving it
+ *
+ * @param [in] strHost host name
+ * @param [in] iPort port of the requests
+ * @param [in] strAddresses addresses separated by commas (IPv6 ones between brackets)
+ *
+ * @retval true   The host is pinned.
+ * @retval false  Invalid host, port or addresses.
+ */
+const bool CHTTPDnsCache::Pin(const std::string& strHost, const int iPort, const std::string& strAddresses)
+{
+   if (strHost.empty() || iPort <= 0 || iPort > 65535 || strAddresses.empty())
+      return false;
+
+   std::lock_guard<std::mutex> lock(m_mtxEntries);
+
+   Entry& PinnedEntry = m_mapEntries[MakeKey(strHost, iPort)];
+   PinnedEntry.strHost = strHost;
+   PinnedEntry.iPort = iPort;
+   PinnedEntry.strAddresses = strAddresses;
+   PinnedEntry.bPinned = true;
+
+   return true;
+}
+
+/**
+ * @brief pins hosts from a configuration text : one "host:port:address[,address...]"
+ * entry per line (CURLOPT_RESOLVE format), empty lines and lines starting with '#' are
+ * ignored
+ *
+ * @param [in] strEntries entries to load
+ *
+ * @return number of hosts pinned (the invalid entries are skipped)
+ */
+const size_t CHTTPDnsCache::LoadPins(const std::string& strEntries)
+{
+   size_t usPinned = 0;
+   size_t usLineStart = 0;
+   while (usLineStart < strEntries.size())
+   {
+      size_t usLineEnd = strEntries.find('\n', usLineStart);
+      if (usLineEnd == std::string::npos)
+         usLineEnd = strEntries.size();
+
+      std::string strLine = strEntries.substr(usLineStart, usLineEnd - usLineStart);
+      usLineStart = usLineEnd + 1;
+
+      strLine.erase(0, strLine.find_first_not_of(" \t"));
+      strLine.erase(strLine.find_last_not_of(" \t\r") + 1);
+      if (strLine.empty() || strLine[0] == '#')
+         continue;
+
+      const size_t usHostEnd = strLine.find(':');
+      const size_t usPortEnd = (usHostEnd != std::string::npos) ? strLine.find(':', usHostEnd + 1) : std::string::npos;
+      if (usPortEnd == std::string::npos)
+         continue;
+
+      const std::string strPort = strLine.substr(usHostEnd + 1, usPortEnd - usHostEnd - 1);
+      if (strPort.empty() || !std::all_of(strPort.begin(), strPort.end(), [](const char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }))
+         continue;
+
+      if (Pin(strLine.substr(0, usHostEnd), std::atoi(strPort.c_str()), strLine.substr(usPortEnd + 1)))
+         ++usPinned;
+   }
+
+   return usPinned;
+}
+
+/**
+ * @brief removes the pinned addresses of a host, it will be resolved again
+ */
+void CHTTPDnsCache::Unpin(const std::string& strHost, const int iPort)
+{
+   std::lock_guard<std::mutex> lock(m_mtxEntries);
+
+   auto itEntry = m_mapEntries.find(MakeKey(strHost, iPort));
+   if (itEntry != m_mapEntries.end() && itEntry->second.bPinned && !itEntry->second.bRefreshing)
+      m_mapEntries.erase(itEntry);
+}
+
+/**
+ * @brief removes all the entries, pinned ones included
+ */
+void CHTTPDnsCache::Clear()
+{
+   std::lock_guard<std::mutex> lock(m_mtxEntries);
+
+   // the entries being refreshed are evicted by the refresh thread
+   for (auto itEntry = m_mapEntries.begin(); itEntry != m_mapEntries.end();)
+   {
+      if (itEntry->second.bRefreshing)
+      {
+         itEntry->second.tLastUse = Clock::time_point();
+         ++itEntry;
+      }
+      else
+         itEntry = m_mapEntries.erase(itEntry);
+   }
+}
+
+/**
+ * @brief returns the statistics of the cache
+ */
+const CHTTPDnsCache::DnsStats CHTTPDnsCache::GetStats() const
+{
+   std::lock_guard<std::mutex> lock(m_mtxEntries);
+
+   DnsStats Stats = m_Stats;
+   Stats.usEntries = m_mapEntries.size();
+   return Stats;
+}
+
+/**
+ * @brief sets the lifetime of the resolved addresses (applies to the next resolutions)
+ *
+ * @param [in] lTtl lifetime in seconds
+ */
+void CHTTPDnsCache::SetTtl(const long lTtl)
+{
+   std::lock_guard<std::mutex> lock(m_mtxEntries);
+   m_Ttl = std::chrono::seconds(std::max(1L, lTtl));
+}
+
+/**
+ * @brief sets the delay after which unused entries are evicted
+ *
+ * @param [in] lIdleTimeout delay in seconds
+ */
+void CHTTPDnsCache::SetIdleTimeout(const long lIdleTimeout)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mtxEntries);
+      m_IdleTimeout = std::chrono::seconds(std::max(1L, lIdleTimeout));
+   }
+   m_cvRefresh.notify_all();
+}
+
+/**
+ * @brief extracts the host name and the port of an URL
+ *
+ * @param [in] strUrl "http://" or "https://" URL
+ * @param [out] strHost host name in lower case
+ * @param [out] iPort port (80 or 443 if the URL has none)
+ *
+ * @retval true   The URL has a host name.
+ * @retval false  Unknown scheme, IP address or malformed authority.
+ */
+const bool CHTTPDnsCache::SplitUrl(const std::string& strUrl, std::string& strHost, int& iPort)
+{
+   size_t usStart = 0;
+   if (strUrl.compare(0, 7, "http://") == 0 || strUrl.compare(0, 7, "HTTP://") == 0)
+   {
+      usStart = 7;
+      iPort = 80;
+   }
+   else if (strUrl.compare(0, 8, "https://") == 0 || strUrl.compare(0, 8, "HTTPS://") == 0)
+   {
+      usStart = 8;
+      iPort = 443;
+   }
+   else
+      return false;
+
+   size_t usEnd = strUrl.find_first_of("/?#", usStart);
+   if (usEnd == std::string::npos)
+      usEnd = strUrl.size();
+
+   // user information
+   const size_t usAt = strUrl.rfind('@', usEnd);
+   if (usAt != std::string::npos && usAt >= usStart)
+      usStart = usAt + 1;
+
+   // IPv6 address
+   if (usStart >= usEnd || strUrl[usStart] == '[')
+      return false;
+
+   size_t usHostEnd = strUrl.find(':', usStart);
+   if (usHostEnd != std::string::npos && usHostEnd < usEnd)
+   {
+      char* pszPortEnd = nullptr;
+      const long lPort = std::strtol(strUrl.c_str() + usHostEnd + 1, &pszPortEnd, 10);
+      if (pszPortEnd != strUrl.c_str() + usEnd || lPort <= 0 || lPort > 65535)
+         return false;
+      iPort = static_cast<int>(lPort);
+   }
+   else
+      usHostEnd = usEnd;
+
+   if (usHostEnd == usStart)
+      return false;
+
+   strHost.assign(strUrl, usStart, usHostEnd - usStart);
+   std::transform(strHost.begin(), strHost.end(), strHost.begin(),
+                  [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+   // IPv4 address
+   if (strHost.find_first_not_of("0123456789.") == std::string::npos)
+      return false;
+
+   return true;
+}
+
+/**
+ * @brief resolves a host name with the system resolver
+ *
+ * @param [in] strHost host name
+ * @param [in] iPort port of the requests
+ * @param [out] strAddresses addresses separated by commas, IPv6 ones between brackets
+ *
+ * @retval true   The host was resolved.
+ * @retval false  The host couldn't be resolved.
+ */
+const bool CHTTPDnsCache::ResolveHost(const std::string& strHost, const int iPort, std::string& strAddresses)
+{
+   struct addrinfo Hints;
+   std::memset(&Hints, 0, sizeof(Hints));
+   Hints.ai_family = AF_UNSPEC;
+   Hints.ai_socktype = SOCK_STREAM;
+
+   struct addrinfo* pResults = nullptr;
+   if (getaddrinfo(strHost.c_str(), std::to_string(iPort).c_str(), &Hints, &pResults) != 0)
+      return false;
+
+   strAddresses.clear();
+   char szAddress[INET6_ADDRSTRLEN];
+   for (const struct addrinfo* pResult = pResults; pResult != nullptr; pResult = pResult->ai_next)
+   {
+      const bool bIPv6 = pResult->ai_family == AF_INET6;
+      const void* pAddress = nullptr;
+      if (pResult->ai_family == AF_INET)
+         pAddress = &reinterpret_cast<const struct sockaddr_in*>(pResult->ai_addr)->sin_addr;
+      else if (bIPv6)
+         pAddress = &reinterpret_cast<const struct sockaddr_in6*>(pResult->ai_addr)->sin6_addr;
+
+      if (pAddress == nullptr || inet_ntop(pResult->ai_family, pAddress, szAddress, sizeof(szAddress)) == nullptr)
+         continue;
+
+      const std::string strAddress = (bIPv6) ? std::string("[").append(szAddress).append("]") : std::string(szAddress);
+
+      // the resolver returns an address once per protocol
+      if (("," + strAddresses + ",").find("," + strAddress + ",") != std::string::npos)
+         continue;
+
+      if (!strAddresses.empty())
+         strAddresses.push_back(',');
+      strAddresses.append(strAddress);
+   }
+   freeaddrinfo(pResults);
+
+   return !strAddresses.empty();
+}
+
+/**
+ * @brief resolves an entry synchronously, the lock is released during the resolution
+ *
+ * @retval true   The entry has addresses (resolved now, pinned meanwhile...).
+ * @retval false  The host couldn't be resolved.
+ */
+const bool CHTTPDnsCache::ResolveEntry(const std::string& strKey, const std::string& strHost, const int iPort,
+                                       std::unique_lock<std::mutex>& Lock)
+{
+   Lock.unlock();
+
+   std::string strAddresses;
+   const Clock::time_point tStart = Clock::now();
+   const bool bResolved = ResolveHost(strHost, iPort, strAddresses);
+   const long long llResolveTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - tStart).count();
+
+   Lock.lock();
+
+   Entry& CacheEntry = m_mapEntries[strKey];
+   if (CacheEntry.strHost.empty())
+   {
+      CacheEntry.strHost = strHost;
+      CacheEntry.iPort = iPort;
+      CacheEntry.tLastUse = Clock::now();
+      StartRefreshThread();
+   }
+
+   if (!CacheEntry.bPinned)
+      StoreAddresses(CacheEntry, strAddresses, bResolved, llResolveTimeUs);
+   else
+   {
+      m_Stats.llResolveTimeUs += llResolveTimeUs;
+      m_Stats.llLastResolveTimeUs = llResolveTimeUs;
+   }
+
+   return !CacheEntry.strAddresses.empty() && (CacheEntry.bPinned || bResolved);
+}
+
+/**
+ * @brief updates an entry after a resolution (the lock must be held)
+ */
+void CHTTPDnsCache::StoreAddresses(Entry& CacheEntry, const std::string& strAddresses, const bool bResolved,
+                                   const long long llResolveTimeUs)
+{
+   const Clock::time_point tNow = Clock::now();
+
+   m_Stats.llResolveTimeUs += llResolveTimeUs;
+   m_Stats.llLastResolveTimeUs = llResolveTimeUs;
+
+   if (bResolved)
+   {
+      CacheEntry.strAddresses = strAddresses;
+      CacheEntry.tExpiry = tNow + m_Ttl;
+      CacheEntry.tRefresh = tNow + RefreshDelay(m_Ttl);
+   }
+   else
+   {
+      // the previous addresses are kept until they expire
+      ++m_Stats.usFailures;
+      CacheEntry.tRefresh = tNow + RetryDelay(m_Ttl);
+   }
+}
+
+/**
+ * @brief starts the refresh thread if it isn't running (the lock must be held)
+ */
+void CHTTPDnsCache::StartRefreshThread()
+{
+   if (!m_RefreshThread.joinable() && !m_bStopping)
+      m_RefreshThread = std::thread(&CHTTPDnsCache::RefreshLoop, this);
+}
+
+/**
+ * @brief body of the refresh thread : refreshes the entries before they expire and evicts
+ * the unused ones
+ */
+void CHTTPDnsCache::RefreshLoop()
+{
+   std::vector<std::string> vecDueKeys;
+
+   std::unique_lock<std::mutex> lock(m_mtxEntries);
+   while (!m_bStopping)
+   {
+      const Clock::time_point tNow = Clock::now();
+      Clock::time_point tWakeUp = tNow + m_IdleTimeout;
+
+      vecDueKeys.clear();
+      for (auto itEntry = m_mapEntries.begin(); itEntry != m_mapEntries.end();)
+      {
+         Entry& CacheEntry = itEntry->second;
+         if (CacheEntry.bPinned || CacheEntry.bRefreshing)
+         {
+            ++itEntry;
+            continue;
+         }
+
+         if (tNow - CacheEntry.tLastUse >= m_IdleTimeout)
+         {
+            itEntry = m_mapEntries.erase(itEntry);
+            continue;
+         }
+
+         if (CacheEntry.tRefresh <= tNow)
+         {
+            CacheEntry.bRefreshing = true;
+            vecDueKeys.push_back(itEntry->first);
+         }
+         else
+            tWakeUp = std::min(tWakeUp, CacheEntry.tRefresh);
+
+         tWakeUp = std::min(tWakeUp, CacheEntry.tLastUse + m_IdleTimeout);
+         ++itEntry;
+      }
+
+      if (vecDueKeys.empty())
+      {
+         m_cvRefresh.wait_until(lock, tWakeUp);
+         continue;
+      }
+
+      for (const std::string& strKey : vecDueKeys)
+      {
+         auto itEntry = m_mapEntries.find(strKey);
+         if (itEntry == m_mapEntries.end())
+            continue;
+
+         const std::string strHost = itEntry->second.strHost;
+         const int iPort = itEntry->second.iPort;
+
+         lock.unlock();
+
+         std::string strAddresses;
+         const Clock::time_point tStart = Clock::now();
+         const bool bResolved = ResolveHost(strHost, iPort, strAddresses);
+         const long long llResolveTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - tStart).count();
+
+         lock.lock();
+
+         // the entries can't be erased while they are being refreshed
+         itEntry = m_mapEntries.find(strKey);
+         itEntry->second.bRefreshing = false;
+         if (!itEntry->second.bPinned)
+         {
+            ++m_Stats.usRefreshes;
+            StoreAddresses(itEntry->second, strAddresses, bResolved, llResolveTimeUs);
+         }
+
+         if (m_bStopping)
+            break;
+      }
+   }
+}
+
+/**
+ * @brief returns the key of an entry : "host:port"
+ */
+std::string CHTTPDnsCache::MakeKey(const std::string& strHost, const int iPort)
+{
+   std::string strKey(strHost);
+   std::transform(strKey.begin(), strKey.end(), strKey.begin(),
+                  [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+   return strKey.append(1, ':').append(std::to_string(iPort));
+}
@@ -0,0 +1,113 @@
+/*
+ * @file HTTPDnsCache.h
+ * @brief process-wide DNS cache refreshed in the background, with static host pinning
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPDNSCACHE_H_
+#define INCLUDE_HTTPDNSCACHE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>         // std::size_t
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/* Resolves the hosts of the requests outside of libcurl and hands the addresses over to
+ * the transfers (CURLOPT_RESOLVE), so a host is resolved once for all the sessions of the
+ * process instead of once per handle (see CHTTPClient::SetDnsCache).
+ *
+ * An entry is resolved synchronously the first time its host is requested, then it is
+ * refreshed by a background thread before it expires, so the requests don't wait for the
+ * resolver as long as their host keeps being requested. The entries unused for the idle
+ * timeout are evicted instead of being refreshed. If a refresh fails, the previous
+ * addresses are kept until they expire and the refresh is retried.
+ *
+ * The system resolver doesn't report the records' TTL : the entries live for a configured
+ * TTL (60 seconds by default).
+ *
+ * Pinned hosts (same format as CURLOPT_RESOLVE : "host:port:address[,address...]") are
+ * never resolved nor evicted. The class is thread-safe. */
+class CHTTPDnsCache
+{
+public:
+   struct DnsStats
+   {
+      DnsStats() : usHits(0), usMisses(0), usRefreshes(0), usFailures(0), usEntries(0),
+                   llResolveTimeUs(0), llLastResolveTimeUs(0) {}
+      size_t    usHits;                // lookups answered from the cache
+      size_t    usMisses;              // lookups resolved synchronously
+      size_t    usRefreshes;           // background resolutions
+      size_t    usFailures;            // failed resolutions (synchronous or background)
+      size_t    usEntries;
+      long long llResolveTimeUs;       // total time spent in the resolver (microseconds)
+      long long llLastResolveTimeUs;   // duration of the last resolution (microseconds)
+   };
+
+   /* lTtl : lifetime of the resolved addresses, lIdleTimeout : entries unused for this long
+    * are evicted (in seconds) */
+   explicit CHTTPDnsCache(const long lTtl = 60, const long lIdleTimeout = 300);
+   virtual ~CHTTPDnsCache();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPDnsCache(const CHTTPDnsCache& Copy) = delete;
+   CHTTPDnsCache& operator=(const CHTTPDnsCache& Copy) = delete;
+
+   // cache shared by the whole process
+   static CHTTPDnsCache& Global();
+
+   const bool Lookup(const std::string& strUrl, std::string& strResolveEntry);
+   void Prefetch(const std::string& strUrl);
+
+   const bool Pin(const std::string& strHost, const int iPort, const std::string& strAddresses);
+   const size_t LoadPins(const std::string& strEntries);
+   void Unpin(const std::string& strHost, const int iPort);
+   void Clear();
+
+   const DnsStats GetStats() const;
+   void SetTtl(const long lTtl);
+   void SetIdleTimeout(const long lIdleTimeout);
+
+   // Helpers
+   static const bool SplitUrl(const std::string& strUrl, std::string& strHost, int& iPort);
+   static const bool ResolveHost(const std::string& strHost, const int iPort, std::string& strAddresses);
+
+protected:
+   typedef std::chrono::steady_clock Clock;
+
+   struct Entry
+   {
+      Entry() : iPort(0), bPinned(false), bRefreshing(false) {}
+      std::string       strHost;
+      int               iPort;
+      std::string       strAddresses;   // "address[,address...]", empty if not resolved yet
+      Clock::time_point tExpiry;
+      Clock::time_point tRefresh;       // when the background thread refreshes the entry
+      Clock::time_point tLastUse;
+      bool              bPinned;
+      bool              bRefreshing;
+   };
+
+   const bool ResolveEntry(const std::string& strKey, const std::string& strHost, const int iPort,
+                           std::unique_lock<std::mutex>& Lock);
+   void StoreAddresses(Entry& CacheEntry, const std::string& strAddresses, const bool bResolved,
+                       const long long llResolveTimeUs);
+   void StartRefreshThread();
+   void RefreshLoop();
+   static std::string MakeKey(const std::string& strHost, const int iPort);
+
+   std::unordered_map<std::string, Entry> m_mapEntries;   // "host:port" -> entry
+   std::chrono::seconds                   m_Ttl;
+   std::chrono::seconds                   m_IdleTimeout;
+   DnsStats                               m_Stats;
+
+   mutable std::mutex                     m_mtxEntries;
+   std::condition_variable                m_cvRefresh;
+   std::thread                            m_RefreshThread;
+   bool                                   m_bStopping;
+};
+
+#endif
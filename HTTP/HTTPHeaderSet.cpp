@@ -0,0 +1,133 @@
+/**
+* @file HTTPHeaderSet.cpp
+* @brief implementation of the shared set of request headers
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPHeaderSet.h"
+
+/**
+ * @brief builds the set of headers
+ *
+ * @param [in] Headers headers (name, value) to send on every request
+ */
+CHTTPHeaderSet::CHTTPHeaderSet(const HeadersMap& Headers) :
+   m_pHeaderlist(nullptr),
+   m_pLastNode(nullptr),
+   m_usSize(0)
+{
+   std::string strHeader;
+   for (HeadersMap::const_iterator it = Headers.cbegin();
+      it != Headers.cend();
+      ++it)
+   {
+      strHeader.assign(it->first).append(": ").append(it->second); // build header string
+      Append(strHeader);
+   }
+}
+
+/**
+ * @brief builds the set of headers, the order of the lines is kept
+ *
+ * @param [in] vecLines headers to send on every request ("Name: value")
+ */
+CHTTPHeaderSet::CHTTPHeaderSet(const std::vector<std::string>& vecLines) :
+   m_pHeaderlist(nullptr),
+   m_pLastNode(nullptr),
+   m_usSize(0)
+{
+   for (const std::string& strLine : vecLines)
+      Append(strLine);
+}
+
+CHTTPHeaderSet::~CHTTPHeaderSet()
+{
+   if (m_pHeaderlist)
+      curl_slist_free_all(m_pHeaderlist);
+}
+
+/**
+ * @brief appends a header line to the list (construction only)
+ */
+void CHTTPHeaderSet::Append(const std::string& strLine)
+{
+   struct curl_slist* pList = curl_slist_append(m_pLastNode, strLine.c_str());
+   if (pList == nullptr)
+      return;
+
+   // curl_slist_append returns the head of the list it was given
+   if (m_pHeaderlist == nullptr)
+      m_pHeaderlist = pList;
+
+   m_pLastNode = (m_pLastNode == nullptr) ? pList : m_pLastNode->next;
+   ++m_usSize;
+}
+
+/**
+ * @brief checks if the set has a header
+ *
+ * @param [in] strName name of the header (case-insensitive)
+ *
+ * @retval true   The set contains the header.
+ * @retval false  The set doesn't contain the header.
+ */
+const bool CHTTPHeaderSet::Contains(const std::string& strName) const
+{
+   for (const struct curl_slist* pNode = m_pHeaderlist; pNode != nullptr; pNode = pNode->next)
+   {
+      if (HasName(pNode->data, strName))
+         return true;
+   }
+   return false;
+}
+
+/**
+ * @brief checks if at least one header of the set is replaced by per-request headers
+ *
+ * @param [in] Overrides per-request headers
+ *
+ * @retval true   At least one header of the set has the name of a per-request header.
+ * @retval false  The per-request headers can be sent along with the whole set.
+ */
+const bool CHTTPHeaderSet::IsOverridden(const HeadersMap& Overrides) const
+{
+   for (HeadersMap::const_iterator it = Overrides.cbegin();
+      it != Overrides.cend();
+      ++it)
+   {
+      if (Contains(it->first))
+         return true;
+   }
+   return false;
+}
+
+/**
+ * @brief checks the name of a header line, without copying it
+ *
+ * @param [in] pszLine header line ("Name: value", "Name;" or "Name:")
+ * @param [in] strName name of the header (case-insensitive)
+ *
+ * @retval true   The line is a strName header.
+ * @retval false  The line is another header.
+ */
+const bool CHTTPHeaderSet::HasName(const char* pszLine, const std::string& strName)
+{
+   for (size_t i = 0; i < strName.size(); ++i)
+   {
+      char c = pszLine[i];
+      if (c == '\0')
+         return false;
+      if (c >= 'A' && c <= 'Z')
+         c = static_cast<char>(c - 'A' + 'a');
+
+      char n = strName[i];
+      if (n >= 'A' && n <= 'Z')
+         n = static_cast<char>(n - 'A' + 'a');
+
+      if (c != n)
+         return false;
+   }
+
+   const char cSeparator = pszLine[strName.size()];
+   return cSeparator == ':' || cSeparator == ';';
+}
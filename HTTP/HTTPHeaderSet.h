@@ -0,0 +1,56 @@
+/*
+ * @file HTTPHeaderSet.h
+ * @brief immutable set of request headers, built once and shared by requests and clients
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPHEADERSET_H_
+#define INCLUDE_HTTPHEADERSET_H_
+
+#include <cstddef>         // std::size_t
+#include <curl/curl.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Headers sent on every request (authorization, tracing, content type...) are formatted
+ * once into a curl_slist when the set is built. The set can't be modified afterwards, so
+ * it can be shared (see CHTTPClient::SetHeaderSet) by several clients used from different
+ * threads : libcurl only reads the list.
+ *
+ * The headers passed to a REST request are layered on top of the set : they are sent
+ * first and replace the headers of the set having the same name (case-insensitive). */
+class CHTTPHeaderSet
+{
+public:
+   // same type as CHTTPClient::HeadersMap
+   typedef std::unordered_map<std::string, std::string> HeadersMap;
+
+   explicit CHTTPHeaderSet(const HeadersMap& Headers);
+   explicit CHTTPHeaderSet(const std::vector<std::string>& vecLines); // "Name: value"
+   virtual ~CHTTPHeaderSet();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPHeaderSet(const CHTTPHeaderSet& Copy) = delete;
+   CHTTPHeaderSet& operator=(const CHTTPHeaderSet& Copy) = delete;
+
+   inline const struct curl_slist* GetList() const { return m_pHeaderlist; }
+   inline const size_t GetSize() const { return m_usSize; }
+   inline const bool IsEmpty() const { return m_usSize == 0; }
+
+   const bool Contains(const std::string& strName) const;
+   const bool IsOverridden(const HeadersMap& Overrides) const;
+
+   // Helpers
+   static const bool HasName(const char* pszLine, const std::string& strName);
+
+protected:
+   void Append(const std::string& strLine);
+
+   struct curl_slist*   m_pHeaderlist;
+   struct curl_slist*   m_pLastNode;
+   size_t               m_usSize;
+};
+
+#endif
@@ -0,0 +1,533 @@
+/**
+* @file HTTPJsonStream.cpp
+* @brief implementation of the incremental JSON parser
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPJsonStream.h"
+
+#include <cerrno>
+#include <cstdlib>         // strtod, strtoll, strtoull
+#include <limits>
+
+/**
+ * @brief constructor of the parser
+ *
+ * @param [in] Handler receives the events, it must outlive the parser
+ */
+CHTTPJsonStream::CHTTPJsonStream(CHTTPJsonHandler& Handler) :
+   m_Handler(Handler)
+{
+   Reset();
+}
+
+/**
+ * @brief destructor of the parser
+ */
+CHTTPJsonStream::~CHTTPJsonStream()
+{
+}
+
+/**
+ * @brief prepares the parser for a new document, the buffers are kept
+ */
+void CHTTPJsonStream::Reset()
+{
+   m_eState = STATE_VALUE;
+   m_eToken = TOKEN_NONE;
+   m_bKey = false;
+   m_strToken.clear();
+   m_pszLiteral = nullptr;
+   m_usLiteralPos = 0;
+   m_uCodeUnit = 0;
+   m_usHexDigits = 0;
+   m_uHighSurrogate = 0;
+   m_vecStack.clear();
+   m_eError = JSON_OK;
+   m_usErrorOffset = 0;
+   m_usOffset = 0;
+}
+
+/**
+ * @brief parses the next chunk of the document, the events are sent to the handler
+ *
+ * @param [in] pData chunk, it isn't referenced after the call
+ * @param [in] usSize size of the chunk
+ *
+ * @retval true   The chunk was parsed, the document may be incomplete.
+ * @retval false  The document is invalid or the handler stopped the parsing (see GetError()).
+ */
+const bool CHTTPJsonStream::Parse(const char* pData, const size_t usSize)
+{
+   if (m_eError != JSON_OK)
+      return false;
+
+   size_t i = 0;
+   bool bOk = true;
+   while (bOk && i < usSize)
+   {
+      const char c = pData[i];
+
+      switch (m_eToken)
+      {
+      case TOKEN_STRING:
+      {
+         // a high surrogate must be followed by its low surrogate
+         if (m_uHighSurrogate != 0 && c != '\\')
+         {
+            bOk = Fail(JSON_ERROR_STRING);
+            break;
+         }
+
+         // the characters up to the end of the string, or to an escape sequence, are
+         // delivered from the chunk when the string started in it
+         const size_t usStart = i;
+         while (i < usSize && pData[i] != '"' && pData[i] != '\\' &&
+                static_cast<unsigned char>(pData[i]) >= 0x20)
+            ++i;
+
+         if (i == usSize)
+            m_strToken.append(pData + usStart, i - usStart);
+         else if (pData[i] == '"')
+         {
+            if (m_strToken.empty())
+               bOk = EndString(pData + usStart, i - usStart);
+            else
+            {
+               m_strToken.append(pData + usStart, i - usStart);
+               bOk = EndString(m_strToken.data(), m_strToken.size());
+            }
+            ++i;
+         }
+         else if (pData[i] == '\\')
+         {
+            m_strToken.append(pData + usStart, i - usStart);
+            m_eToken = TOKEN_ESCAPE;
+            ++i;
+         }
+         else
+            bOk = Fail(JSON_ERROR_STRING);
+         break;
+      }
+
+      case TOKEN_ESCAPE:
+         m_eToken = TOKEN_STRING;
+         if (m_uHighSurrogate != 0 && c != 'u')
+         {
+            bOk = Fail(JSON_ERROR_STRING);
+            break;
+         }
+
+         switch (c)
+         {
+         case '"':
+         case '\\':
+         case '/': m_strToken.push_back(c); break;
+         case 'b': m_strToken.push_back('\b'); break;
+         case 'f': m_strToken.push_back('\f'); break;
+         case 'n': m_strToken.push_back('\n'); break;
+         case 'r': m_strToken.push_back('\r'); break;
+         case 't': m_strToken.push_back('\t'); break;
+         case 'u':
+            m_eToken = TOKEN_UNICODE;
+            m_uCodeUnit = 0;
+            m_usHexDigits = 0;
+            break;
+         default:
+            bOk = Fail(JSON_ERROR_STRING);
+            break;
+         }
+         ++i;
+         break;
+
+      case TOKEN_UNICODE:
+      {
+         uint32_t uDigit = 0;
+         if (c >= '0' && c <= '9')
+            uDigit = c - '0';
+         else if (c >= 'a' && c <= 'f')
+            uDigit = c - 'a' + 10;
+         else if (c >= 'A' && c <= 'F')
+            uDigit = c - 'A' + 10;
+         else
+         {
+            bOk = Fail(JSON_ERROR_STRING);
+            break;
+         }
+         ++i;
+
+         m_uCodeUnit = (m_uCodeUnit << 4) | uDigit;
+         if (++m_usHexDigits < 4)
+            break;
+
+         m_eToken = TOKEN_STRING;
+         const bool bHigh = m_uCodeUnit >= 0xD800 && m_uCodeUnit <= 0xDBFF;
+         const bool bLow = m_uCodeUnit >= 0xDC00 && m_uCodeUnit <= 0xDFFF;
+
+         if (m_uHighSurrogate != 0)
+         {
+            if (!bLow)
+            {
+               bOk = Fail(JSON_ERROR_STRING);
+               break;
+            }
+            AppendCodePoint(0x10000 + ((m_uHighSurrogate - 0xD800) << 10) + (m_uCodeUnit - 0xDC00));
+            m_uHighSurrogate = 0;
+         }
+         else if (bHigh)
+            m_uHighSurrogate = m_uCodeUnit;
+         else if (bLow)
+            bOk = Fail(JSON_ERROR_STRING);
+         else
+            AppendCodePoint(m_uCodeUnit);
+         break;
+      }
+
+      case TOKEN_NUMBER:
+         if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+         {
+            m_strToken.push_back(c);
+            ++i;
+         }
+         else
+            bOk = EndNumber(); // the character is parsed in the next iteration
+         break;
+
+      case TOKEN_LITERAL:
+         if (c != m_pszLiteral[m_usLiteralPos])
+         {
+            bOk = Fail(JSON_ERROR_SYNTAX);
+            break;
+         }
+         ++i;
+
+         if (m_pszLiteral[++m_usLiteralPos] == '\0')
+         {
+            m_eToken = TOKEN_NONE;
+            switch (m_pszLiteral[0])
+            {
+            case 't': bOk = m_Handler.Bool(true); break;
+            case 'f': bOk = m_Handler.Bool(false); break;
+            default:  bOk = m_Handler.Null(); break;
+            }
+            bOk = (bOk) ? EndValue() : Fail(JSON_ERROR_ABORTED);
+         }
+         break;
+
+      case TOKEN_NONE:
+      default:
+         ++i;
+         if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+            break;
+
+         switch (m_eState)
+         {
+         case STATE_VALUE:
+            bOk = StartValue(c);
+            break;
+
+         case STATE_FIRST_ELEMENT:
+            bOk = (c == ']') ? EndContainer() : StartValue(c);
+            break;
+
+         case STATE_FIRST_KEY:
+         case STATE_KEY:
+            if (c == '"')
+            {
+               m_bKey = true;
+               m_eToken = TOKEN_STRING;
+            }
+            else if (c == '}' && m_eState == STATE_FIRST_KEY)
+               bOk = EndContainer();
+            else
+               bOk = Fail(JSON_ERROR_SYNTAX);
+            break;
+
+         case STATE_COLON:
+            if (c == ':')
+               m_eState = STATE_VALUE;
+            else
+               bOk = Fail(JSON_ERROR_SYNTAX);
+            break;
+
+         case STATE_NEXT:
+            if (c == ',')
+               m_eState = (m_vecStack.back().bObject) ? STATE_KEY : STATE_VALUE;
+            else if (c == (m_vecStack.back().bObject ? '}' : ']'))
+               bOk = EndContainer();
+            else
+               bOk = Fail(JSON_ERROR_SYNTAX);
+            break;
+
+         case STATE_DONE:
+         default:
+            bOk = Fail(JSON_ERROR_SYNTAX);
+            break;
+         }
+         break;
+      }
+   }
+
+   if (!bOk)
+   {
+      m_usErrorOffset = m_usOffset + i;
+      return false;
+   }
+
+   m_usOffset += usSize;
+
+   return true;
+}
+
+/**
+ * @brief signals the end of the document (e.g. the end of the response body)
+ *
+ * @retval true   A complete document was parsed.
+ * @retval false  The document is invalid or incomplete (see GetError()).
+ */
+const bool CHTTPJsonStream::Finish()
+{
+   if (m_eError != JSON_OK)
+      return false;
+
+   // a number at the top level has no delimiter
+   if (m_eToken == TOKEN_NUMBER && m_vecStack.empty() && !EndNumber())
+   {
+      m_usErrorOffset = m_usOffset;
+      return false;
+   }
+
+   if (m_eState != STATE_DONE || m_eToken != TOKEN_NONE)
+   {
+      m_usErrorOffset = m_usOffset;
+      return Fail(JSON_ERROR_INCOMPLETE);
+   }
+
+   return true;
+}
+
+/**
+ * @brief stops the parsing
+ *
+ * @return false
+ */
+const bool CHTTPJsonStream::Fail(const JsonError eError)
+{
+   m_eError = eError;
+   return false;
+}
+
+/**
+ * @brief starts a value whose first character is c
+ */
+const bool CHTTPJsonStream::StartValue(const char c)
+{
+   switch (c)
+   {
+   case '{':
+      m_vecStack.push_back({ true, 0 });
+      m_eState = STATE_FIRST_KEY;
+      return m_Handler.StartObject() || Fail(JSON_ERROR_ABORTED);
+
+   case '[':
+      m_vecStack.push_back({ false, 0 });
+      m_eState = STATE_FIRST_ELEMENT;
+      return m_Handler.StartArray() || Fail(JSON_ERROR_ABORTED);
+
+   case '"':
+      m_bKey = false;
+      m_eToken = TOKEN_STRING;
+      return true;
+
+   case 't':
+      m_pszLiteral = "true";
+      break;
+   case 'f':
+      m_pszLiteral = "false";
+      break;
+   case 'n':
+      m_pszLiteral = "null";
+      break;
+
+   default:
+      if (c == '-' || (c >= '0' && c <= '9'))
+      {
+         m_strToken.assign(1, c);
+         m_eToken = TOKEN_NUMBER;
+         return true;
+      }
+      return Fail(JSON_ERROR_SYNTAX);
+   }
+
+   m_eToken = TOKEN_LITERAL;
+   m_usLiteralPos = 1;
+
+   return true;
+}
+
+/**
+ * @brief a value was parsed : updates the parent container
+ */
+const bool CHTTPJsonStream::EndValue()
+{
+   if (m_vecStack.empty())
+      m_eState = STATE_DONE;
+   else
+   {
+      ++m_vecStack.back().usCount;
+      m_eState = STATE_NEXT;
+   }
+
+   return true;
+}
+
+/**
+ * @brief closes the innermost object or array
+ */
+const bool CHTTPJsonStream::EndContainer()
+{
+   const Container Top = m_vecStack.back();
+   m_vecStack.pop_back();
+
+   const bool bOk = (Top.bObject) ? m_Handler.EndObject(Top.usCount) : m_Handler.EndArray(Top.usCount);
+
+   return (bOk) ? EndValue() : Fail(JSON_ERROR_ABORTED);
+}
+
+/**
+ * @brief a string (or a key) was parsed
+ *
+ * @param [in] pszValue unescaped characters, in the chunk or in the token buffer
+ * @param [in] usLength number of characters
+ */
+const bool CHTTPJsonStream::EndString(const char* pszValue, const size_t usLength)
+{
+   m_eToken = TOKEN_NONE;
+
+   bool bOk;
+   if (m_bKey)
+   {
+      bOk = m_Handler.Key(pszValue, usLength);
+      m_eState = STATE_COLON;
+   }
+   else
+      bOk = m_Handler.String(pszValue, usLength) && EndValue();
+
+   m_strToken.clear();
+
+   return bOk || Fail(JSON_ERROR_ABORTED);
+}
+
+/**
+ * @brief a number was parsed : integers are reported as such if they fit in 64 bits
+ */
+const bool CHTTPJsonStream::EndNumber()
+{
+   m_eToken = TOKEN_NONE;
+
+   if (!IsValidNumber(m_strToken))
+      return Fail(JSON_ERROR_NUMBER);
+
+   bool bOk = false;
+   bool bDone = false;
+   if (m_strToken.find_first_of(".eE") == std::string::npos)
+   {
+      errno = 0;
+      if (m_strToken[0] == '-')
+      {
+         const long long llValue = std::strtoll(m_strToken.c_str(), nullptr, 10);
+         if (errno != ERANGE)
+         {
+            bOk = m_Handler.Int64(static_cast<int64_t>(llValue));
+            bDone = true;
+         }
+      }
+      else
+      {
+         const unsigned long long ullValue = std::strtoull(m_strToken.c_str(), nullptr, 10);
+         if (errno != ERANGE)
+         {
+            bOk = (ullValue <= static_cast<unsigned long long>(std::numeric_limits<int64_t>::max())) ?
+               m_Handler.Int64(static_cast<int64_t>(ullValue)) : m_Handler.Uint64(static_cast<uint64_t>(ullValue));
+            bDone = true;
+         }
+      }
+   }
+
+   // decimal number or integer too large for 64 bits
+   if (!bDone)
+      bOk = m_Handler.Double(std::strtod(m_strToken.c_str(), nullptr));
+
+   m_strToken.clear();
+
+   return (bOk) ? EndValue() : Fail(JSON_ERROR_ABORTED);
+}
+
+/**
+ * @brief appends a code point to the token buffer, encoded in UTF-8
+ */
+void CHTTPJsonStream::AppendCodePoint(const uint32_t uCodePoint)
+{
+   if (uCodePoint < 0x80)
+      m_strToken.push_back(static_cast<char>(uCodePoint));
+   else if (uCodePoint < 0x800)
+   {
+      m_strToken.push_back(static_cast<char>(0xC0 | (uCodePoint >> 6)));
+      m_strToken.push_back(static_cast<char>(0x80 | (uCodePoint & 0x3F)));
+   }
+   else if (uCodePoint < 0x10000)
+   {
+      m_strToken.push_back(static_cast<char>(0xE0 | (uCodePoint >> 12)));
+      m_strToken.push_back(static_cast<char>(0x80 | ((uCodePoint >> 6) & 0x3F)));
+      m_strToken.push_back(static_cast<char>(0x80 | (uCodePoint & 0x3F)));
+   }
+   else
+   {
+      m_strToken.push_back(static_cast<char>(0xF0 | (uCodePoint >> 18)));
+      m_strToken.push_back(static_cast<char>(0x80 | ((uCodePoint >> 12) & 0x3F)));
+      m_strToken.push_back(static_cast<char>(0x80 | ((uCodePoint >> 6) & 0x3F)));
+      m_strToken.push_back(static_cast<char>(0x80 | (uCodePoint & 0x3F)));
+   }
+}
+
+/**
+ * @brief checks a number against the JSON grammar : -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+const bool CHTTPJsonStream::IsValidNumber(const std::string& strNumber)
+{
+   const char* p = strNumber.c_str();
+   auto IsDigit = [](const char c) { return c >= '0' && c <= '9'; };
+
+   if (*p == '-')
+      ++p;
+
+   if (*p == '0')
+      ++p;
+   else if (IsDigit(*p))
+      while (IsDigit(*p))
+         ++p;
+   else
+      return false;
+
+   if (*p == '.')
+   {
+      ++p;
+      if (!IsDigit(*p))
+         return false;
+      while (IsDigit(*p))
+         ++p;
+   }
+
+   if (*p == 'e' || *p == 'E')
+   {
+      ++p;
+      if (*p == '+' || *p == '-')
+         ++p;
+      if (!IsDigit(*p))
+         return false;
+      while (IsDigit(*p))
+         ++p;
+   }
+
+   return *p == '\0';
+}
@@ -0,0 +1,126 @@
+/*
+ * @file HTTPJsonStream.h
+ * @brief incremental (push) JSON parser fed with a response body as it is received
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPJSONSTREAM_H_
+#define INCLUDE_HTTPJSONSTREAM_H_
+
+#include <cstddef>         // std::size_t
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Receives the SAX events of a CHTTPJsonStream, the names are those of rapidjson's
+ * handlers. Every method returns false to stop the parsing (the request is aborted).
+ * Strings and keys are not null-terminated, they are only valid during the call. */
+class CHTTPJsonHandler
+{
+public:
+   virtual ~CHTTPJsonHandler() {}
+
+   virtual bool Null() { return true; }
+   virtual bool Bool(bool /*bValue*/) { return true; }
+   virtual bool Int64(int64_t /*iValue*/) { return true; }
+   virtual bool Uint64(uint64_t /*uValue*/) { return true; }   // integers above INT64_MAX
+   virtual bool Double(double /*dValue*/) { return true; }
+   virtual bool String(const char* /*pszValue*/, size_t /*usLength*/) { return true; }
+   virtual bool Key(const char* /*pszKey*/, size_t /*usLength*/) { return true; }
+   virtual bool StartObject() { return true; }
+   virtual bool EndObject(size_t /*usMemberCount*/) { return true; }
+   virtual bool StartArray() { return true; }
+   virtual bool EndArray(size_t /*usElementCount*/) { return true; }
+};
+
+/* Parses a JSON document delivered in chunks of any size (see CHTTPClient::Get) : the
+ * handler receives the events while the body is being transferred, so the parsing overlaps
+ * the network time and the document is never held in memory. The parser keeps its state
+ * between chunks, only the tokens split by a chunk boundary (or containing escape
+ * sequences) are copied into an internal buffer, which is reused.
+ *
+ * One document is parsed, only whitespace may follow it. */
+class CHTTPJsonStream
+{
+public:
+   enum JsonError
+   {
+      JSON_OK,
+      JSON_ERROR_SYNTAX,       // unexpected character
+      JSON_ERROR_STRING,       // invalid escape sequence or control character in a string
+      JSON_ERROR_NUMBER,       // malformed number
+      JSON_ERROR_INCOMPLETE,   // the body ended before the end of the document
+      JSON_ERROR_ABORTED       // the handler stopped the parsing
+   };
+
+   explicit CHTTPJsonStream(CHTTPJsonHandler& Handler);
+   virtual ~CHTTPJsonStream();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPJsonStream(const CHTTPJsonStream& Copy) = delete;
+   CHTTPJsonStream& operator=(const CHTTPJsonStream& Copy) = delete;
+
+   void Reset();
+   const bool Parse(const char* pData, const size_t usSize);
+   const bool Finish();
+
+   inline const bool IsComplete() const { return m_eState == STATE_DONE && m_eError == JSON_OK; }
+   inline const JsonError GetError() const { return m_eError; }
+   inline const size_t GetErrorOffset() const { return m_usErrorOffset; }
+   inline CHTTPJsonHandler& GetHandler() const { return m_Handler; }
+
+protected:
+   enum ParserState
+   {
+      STATE_VALUE,             // a value is expected
+      STATE_FIRST_KEY,         // after '{' : a key or '}'
+      STATE_KEY,               // after ',' in an object
+      STATE_COLON,
+      STATE_FIRST_ELEMENT,     // after '[' : a value or ']'
+      STATE_NEXT,              // after a value in a container : ',' or the end of the container
+      STATE_DONE
+   };
+
+   enum TokenState
+   {
+      TOKEN_NONE,
+      TOKEN_STRING,
+      TOKEN_ESCAPE,            // after '\' in a string
+      TOKEN_UNICODE,           // hexadecimal digits of \uXXXX
+      TOKEN_NUMBER,
+      TOKEN_LITERAL            // true, false or null
+   };
+
+   struct Container
+   {
+      bool   bObject;
+      size_t usCount;
+   };
+
+   const bool Fail(const JsonError eError);
+   const bool StartValue(const char c);
+   const bool EndValue();
+   const bool EndString(const char* pszValue, const size_t usLength);
+   const bool EndNumber();
+   const bool EndContainer();
+   void AppendCodePoint(const uint32_t uCodePoint);
+   static const bool IsValidNumber(const std::string& strNumber);
+
+   CHTTPJsonHandler&        m_Handler;
+   ParserState              m_eState;
+   TokenState               m_eToken;
+   bool                     m_bKey;              // the string being parsed is a key
+   std::string              m_strToken;          // token split by a chunk boundary
+   const char*              m_pszLiteral;        // literal being matched
+   size_t                   m_usLiteralPos;
+   uint32_t                 m_uCodeUnit;         // \uXXXX being decoded
+   size_t                   m_usHexDigits;
+   uint32_t                 m_uHighSurrogate;    // waiting for its low surrogate (0 : none)
+   std::vector<Container>   m_vecStack;
+   JsonError                m_eError;
+   size_t                   m_usErrorOffset;
+   size_t                   m_usOffset;          // bytes parsed before the current chunk
+};
+
+#endif
@@ -0,0 +1,150 @@
+/**
+* @file HTTPLocalAddressPool.cpp
+* @brief implementation of the pool of local source addresses
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPLocalAddressPool.h"
+
+const size_t CHTTPLocalAddressPool::NO_ADDRESS;
+
+/**
+ * @brief constructor of the pool, it holds no address
+ *
+ * @param [in] lHoldTime time an address that couldn't be bound is skipped (in seconds)
+ * @param [in] lConnectionsPerAddress connections a client keeps for each address
+ */
+CHTTPLocalAddressPool::CHTTPLocalAddressPool(const long lHoldTime /* = 30 */,
+                                             const long lConnectionsPerAddress /* = 5 */) :
+   m_usNext(0),
+   m_HoldTime(std::chrono::seconds(lHoldTime)),
+   m_lConnectionsPerAddress((lConnectionsPerAddress > 0) ? lConnectionsPerAddress : 1)
+{
+}
+
+/**
+ * @brief destructor of the pool
+ */
+CHTTPLocalAddressPool::~CHTTPLocalAddressPool()
+{
+}
+
+/**
+ * @brief adds an address to the rotation, must not be called while the pool is used
+ *
+ * @param [in] strAddress address, "if!interface" or "host!name" (see CURLOPT_INTERFACE)
+ * @param [in] lLocalPort first local port the connections can use, 0 for any port
+ * @param [in] lPortRange number of ports from lLocalPort the connections can use
+ *
+ * @retval true   The address is added.
+ * @retval false  The address is empty.
+ */
+const bool CHTTPLocalAddressPool::AddAddress(const std::string& strAddress, const long lLocalPort /* = 0 */,
+                                             const long lPortRange /* = 0 */)
+{
+   if (strAddress.empty())
+      return false;
+
+   std::unique_ptr<Address> pAddress(new Address);
+   pAddress->strAddress = strAddress;
+   pAddress->lLocalPort = lLocalPort;
+   pAddress->lPortRange = (lLocalPort > 0) ? lPortRange : 0;
+   m_vecAddresses.push_back(std::move(pAddress));
+
+   return true;
+}
+
+/**
+ * @brief binds the next transfer of a handle to the next address in turn
+ *
+ * @param [in] pCurl handle of the transfer
+ *
+ * @retval index of the address, to pass to Release once the transfer is done,
+ * NO_ADDRESS if the pool is empty
+ */
+const size_t CHTTPLocalAddressPool::Acquire(CURL* pCurl)
+{
+   if (m_vecAddresses.empty())
+      return NO_ADDRESS;
+
+   const size_t usCount = m_vecAddresses.size();
+   const size_t usFirst = m_usNext.fetch_add(1, std::memory_order_relaxed);
+   const long long llNow = Clock::now().time_since_epoch().count();
+
+   // the held addresses are skipped, unless they all are
+   size_t usIndex = usFirst % usCount;
+   for (size_t usTry = 0; usTry < usCount; ++usTry)
+   {
+      const size_t usCandidate = (usFirst + usTry) % usCount;
+      if (m_vecAddresses[usCandidate]->llHeldUntil.load(std::memory_order_relaxed) <= llNow)
+      {
+         usIndex = usCandidate;
+         break;
+      }
+   }
+
+   const Address& Bound = *m_vecAddresses[usIndex];
+   curl_easy_setopt(pCurl, CURLOPT_INTERFACE, Bound.strAddress.c_str());
+   curl_easy_setopt(pCurl, CURLOPT_LOCALPORT, Bound.lLocalPort);
+   curl_easy_setopt(pCurl, CURLOPT_LOCALPORTRANGE, (Bound.lPortRange > 0) ? Bound.lPortRange : 1L);
+
+   return usIndex;
+}
+
+/**
+ * @brief accounts the transfer of a handle to the address it was bound to
+ *
+ * @param [in] usIndex index returned by Acquire
+ * @param [in] pCurl handle of the transfer
+ * @param [in] eResult result of the transfer
+ */
+void CHTTPLocalAddressPool::Release(const size_t usIndex, CURL* pCurl, const CURLcode eResult)
+{
+   if (usIndex >= m_vecAddresses.size())
+      return;
+
+   Address& Bound = *m_vecAddresses[usIndex];
+
+   long lConnections = 0;
+   curl_off_t iReceived = 0, iSent = 0;
+   curl_easy_getinfo(pCurl, CURLINFO_NUM_CONNECTS, &lConnections);
+   curl_easy_getinfo(pCurl, CURLINFO_SIZE_DOWNLOAD_T, &iReceived);
+   curl_easy_getinfo(pCurl, CURLINFO_SIZE_UPLOAD_T, &iSent);
+
+   ++Bound.usTransfers;
+   Bound.usConnections += static_cast<size_t>(lConnections);
+   Bound.ullBytesReceived += static_cast<uint64_t>(iReceived);
+   Bound.ullBytesSent += static_cast<uint64_t>(iSent);
+
+   if (eResult == CURLE_INTERFACE_FAILED)
+   {
+      ++Bound.usFailures;
+      Bound.llHeldUntil = (Clock::now() + m_HoldTime).time_since_epoch().count();
+   }
+   else if (eResult == CURLE_COULDNT_CONNECT)
+      ++Bound.usFailures;
+}
+
+/**
+ * @brief returns the counters of each address, in the order they were added
+ */
+const std::vector<CHTTPLocalAddressPool::AddressStats> CHTTPLocalAddressPool::GetStats() const
+{
+   const long long llNow = Clock::now().time_since_epoch().count();
+
+   std::vector<AddressStats> vecStats(m_vecAddresses.size());
+   for (size_t usIndex = 0; usIndex < m_vecAddresses.size(); ++usIndex)
+   {
+      const Address& Bound = *m_vecAddresses[usIndex];
+      AddressStats& Stats = vecStats[usIndex];
+      Stats.strAddress = Bound.strAddress;
+      Stats.usTransfers = Bound.usTransfers;
+      Stats.usConnections = Bound.usConnections;
+      Stats.ullBytesReceived = Bound.ullBytesReceived;
+      Stats.ullBytesSent = Bound.ullBytesSent;
+      Stats.usFailures = Bound.usFailures;
+      Stats.bHeld = Bound.llHeldUntil > llNow;
+   }
+
+   return vecStats;
+}
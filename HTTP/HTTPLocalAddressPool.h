@@ -0,0 +1,104 @@
+/*
+ * @file HTTPLocalAddressPool.h
+ * @brief local source addresses (or interfaces) the connections rotate through
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPLOCALADDRESSPOOL_H_
+#define INCLUDE_HTTPLOCALADDRESSPOOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>         // std::size_t
+#include <cstdint>
+#include <curl/curl.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Spreads the connections of the sessions using the pool (see
+ * CHTTPClient::SetLocalAddressPool) over several local addresses : each transfer is bound
+ * (CURLOPT_INTERFACE) to the next address of the pool, in turn, so the traffic goes out
+ * through several links and each address has its own range of ephemeral ports towards an
+ * upstream.
+ *
+ * An address uses CURLOPT_INTERFACE's format : "192.168.1.10", "if!eth1" (interface only),
+ * "host!name" (host name only). It can be restricted to a range of local ports
+ * (CURLOPT_LOCALPORT, CURLOPT_LOCALPORTRANGE).
+ *
+ * libcurl only reuses a connection for a transfer bound to the same address, so each
+ * address keeps its own connections : a client using the pool raises its connection cache
+ * (CURLOPT_MAXCONNECTS, 5 by default) to GetMaxConnections(), otherwise the rotation would
+ * evict the connection the next transfer needs as soon as there are more addresses than
+ * cached connections. An address that can't be bound (CURLE_INTERFACE_FAILED, e.g. its
+ * interface is down) is skipped for the hold time, unless all the addresses are.
+ *
+ * The addresses are added before the pool is used, then the pool is thread-safe. It must
+ * outlive the sessions using it. */
+class CHTTPLocalAddressPool
+{
+public:
+   struct AddressStats
+   {
+      AddressStats() : usTransfers(0), usConnections(0), ullBytesReceived(0), ullBytesSent(0),
+                       usFailures(0), bHeld(false) {}
+      std::string strAddress;
+      size_t      usTransfers;
+      size_t      usConnections;       // new connections (the others were reused)
+      uint64_t    ullBytesReceived;    // bodies' bytes
+      uint64_t    ullBytesSent;
+      size_t      usFailures;          // transfers that couldn't connect
+      bool        bHeld;               // skipped until its hold time is over
+   };
+
+   static const size_t NO_ADDRESS = static_cast<size_t>(-1);
+
+   /* lHoldTime : time an address that couldn't be bound is skipped (in seconds),
+    * lConnectionsPerAddress : connections a client keeps for each address (one per host) */
+   explicit CHTTPLocalAddressPool(const long lHoldTime = 30, const long lConnectionsPerAddress = 5);
+   virtual ~CHTTPLocalAddressPool();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPLocalAddressPool(const CHTTPLocalAddressPool& Copy) = delete;
+   CHTTPLocalAddressPool& operator=(const CHTTPLocalAddressPool& Copy) = delete;
+
+   const bool AddAddress(const std::string& strAddress, const long lLocalPort = 0, const long lPortRange = 0);
+   inline const size_t GetSize() const { return m_vecAddresses.size(); }
+   inline const long GetConnectionsPerAddress() const { return m_lConnectionsPerAddress; }
+   // size of the connection cache of a client using the pool
+   inline const long GetMaxConnections() const
+   {
+      return static_cast<long>(m_vecAddresses.size()) * m_lConnectionsPerAddress;
+   }
+
+   const size_t Acquire(CURL* pCurl);
+   void Release(const size_t usIndex, CURL* pCurl, const CURLcode eResult);
+
+   const std::vector<AddressStats> GetStats() const;
+
+protected:
+   typedef std::chrono::steady_clock Clock;
+
+   struct Address
+   {
+      Address() : lLocalPort(0), lPortRange(0), usTransfers(0), usConnections(0), ullBytesReceived(0),
+                  ullBytesSent(0), usFailures(0), llHeldUntil(0) {}
+      std::string           strAddress;
+      long                  lLocalPort;                 // 0 : any port
+      long                  lPortRange;
+      std::atomic<size_t>   usTransfers;
+      std::atomic<size_t>   usConnections;
+      std::atomic<uint64_t> ullBytesReceived;
+      std::atomic<uint64_t> ullBytesSent;
+      std::atomic<size_t>   usFailures;
+      std::atomic<long long> llHeldUntil;               // Clock's ticks, 0 : not held
+   };
+
+   std::vector<std::unique_ptr<Address>> m_vecAddresses;
+   std::atomic<size_t>                   m_usNext;
+   const Clock::duration                 m_HoldTime;
+   const long                            m_lConnectionsPerAddress;
+};
+
+#endif
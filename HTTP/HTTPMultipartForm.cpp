@@ -0,0 +1,300 @@
+/**
+* @file HTTPMultipartForm.cpp
+* @brief implementation of the multipart/form-data body
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPMultipartForm.h"
+
+#include <algorithm>
+#include <cstdio>          // SEEK_SET, SEEK_CUR, SEEK_END
+#include <cstring>         // memcpy
+
+/**
+ * @brief constructor of the form
+ */
+CHTTPMultipartForm::CHTTPMultipartForm()
+{
+}
+
+/**
+ * @brief destructor of the form
+ */
+CHTTPMultipartForm::~CHTTPMultipartForm()
+{
+}
+
+/**
+ * @brief adds a part whose content is copied (e.g. a text input)
+ *
+ * @param [in] strName name of the part
+ * @param [in] strValue content of the part
+ * @param [in] strContentType content type of the part (none if empty)
+ */
+CHTTPMultipartForm& CHTTPMultipartForm::AddContent(const std::string& strName, const std::string& strValue,
+   const std::string& strContentType /* = std::string() */)
+{
+   AddPart(SOURCE_CONTENT, strName, std::string(), strContentType).strContent = strValue;
+   return *this;
+}
+
+/**
+ * @brief adds a part sent from a caller's buffer without being copied
+ *
+ * @param [in] strName name of the part
+ * @param [in] pData content of the part, it must remain valid until the request returns
+ * @param [in] usSize size of the content
+ * @param [in] strFileName file name announced for the part (none if empty)
+ * @param [in] strContentType content type of the part (none if empty)
+ */
+CHTTPMultipartForm& CHTTPMultipartForm::AddBuffer(const std::string& strName, const void* pData,
+   const size_t usSize, const std::string& strFileName /* = std::string() */,
+   const std::string& strContentType /* = std::string() */)
+{
+   Part& NewPart = AddPart(SOURCE_BUFFER, strName, strFileName, strContentType);
+   NewPart.pData = static_cast<const char*>(pData);
+   NewPart.iSize = static_cast<curl_off_t>(usSize);
+   return *this;
+}
+
+/**
+ * @brief adds a part read from a file while it is sent
+ *
+ * @param [in] strName name of the part
+ * @param [in] strFilePath path of the file to upload
+ * @param [in] strFileName file name announced for the part (the file's name if empty)
+ * @param [in] strContentType content type of the part (deduced by libcurl from the
+ * extension if empty)
+ */
+CHTTPMultipartForm& CHTTPMultipartForm::AddFile(const std::string& strName, const std::string& strFilePath,
+   const std::string& strFileName /* = std::string() */, const std::string& strContentType /* = std::string() */)
+{
+   AddPart(SOURCE_FILE, strName, strFileName, strContentType).strContent = strFilePath;
+   return *this;
+}
+
+/**
+ * @brief adds a part produced on demand while it is sent
+ *
+ * @param [in] strName name of the part
+ * @param [in] fnProducer producer of the content
+ * @param [in] iLength length of the content, -1 if unknown (the body is then chunked)
+ * @param [in] strFileName file name announced for the part (none if empty)
+ * @param [in] strContentType content type of the part (none if empty)
+ */
+CHTTPMultipartForm& CHTTPMultipartForm::AddStream(const std::string& strName,
+   const ProducerFnCallback& fnProducer, const curl_off_t iLength /* = -1 */,
+   const std::string& strFileName /* = std::string() */, const std::string& strContentType /* = std::string() */)
+{
+   Part& NewPart = AddPart(SOURCE_STREAM, strName, strFileName, strContentType);
+   NewPart.fnProducer = fnProducer;
+   NewPart.iSize = iLength;
+   return *this;
+}
+
+/**
+ * @brief adds a header (e.g. "Content-ID: <part1>") to the last added part
+ *
+ * @param [in] strHeader complete header line, without its terminator
+ */
+CHTTPMultipartForm& CHTTPMultipartForm::AddPartHeader(const std::string& strHeader)
+{
+   if (!m_vecParts.empty())
+      m_vecParts.back().vecHeaders.push_back(strHeader);
+   return *this;
+}
+
+/**
+ * @brief returns true if a part is produced on demand (it may pause the upload)
+ */
+const bool CHTTPMultipartForm::HasStreamedParts() const
+{
+   return std::any_of(m_vecParts.begin(), m_vecParts.end(),
+                      [](const Part& FormPart) { return FormPart.eSource == SOURCE_STREAM; });
+}
+
+CHTTPMultipartForm::Part& CHTTPMultipartForm::AddPart(const PartSource eSource, const std::string& strName,
+   const std::string& strFileName, const std::string& strContentType)
+{
+   m_vecParts.emplace_back();
+
+   Part& NewPart = m_vecParts.back();
+   NewPart.eSource = eSource;
+   NewPart.strName = strName;
+   NewPart.strFileName = strFileName;
+   NewPart.strContentType = strContentType;
+   NewPart.pData = nullptr;
+   NewPart.iSize = -1;
+
+   return NewPart;
+}
+
+// MIME UPLOAD
+
+/**
+ * @brief constructor of the MIME structure
+ */
+CHTTPMultipartForm::MimeUpload::MimeUpload() :
+   m_pMime(nullptr)
+{
+}
+
+/**
+ * @brief destructor of the MIME structure, frees it
+ */
+CHTTPMultipartForm::MimeUpload::~MimeUpload()
+{
+   if (m_pMime != nullptr)
+      curl_mime_free(m_pMime);
+}
+
+/**
+ * @brief builds libcurl's MIME structure of a form
+ * only the copied contents are copied by libcurl, the buffers, files and producers are
+ * read while the body is sent
+ *
+ * @param [in] Form form to send, it must not be modified until the end of the transfer
+ * @param [in] pCurl handle performing the transfer
+ *
+ * @return CURLE_OK or the error of the MIME API
+ */
+const CURLcode CHTTPMultipartForm::MimeUpload::Build(const CHTTPMultipartForm& Form, CURL* pCurl)
+{
+   if (m_pMime != nullptr)
+      curl_mime_free(m_pMime);
+   m_vecCursors.clear();
+
+   m_pMime = curl_mime_init(pCurl);
+   if (m_pMime == nullptr)
+      return CURLE_OUT_OF_MEMORY;
+
+   // the callbacks refer to the cursors : they must not be reallocated
+   m_vecCursors.reserve(Form.m_vecParts.size());
+
+   for (const Part& FormPart : Form.m_vecParts)
+   {
+      curl_mimepart* pMimePart = curl_mime_addpart(m_pMime);
+      if (pMimePart == nullptr)
+         return CURLE_OUT_OF_MEMORY;
+
+      CURLcode res = curl_mime_name(pMimePart, FormPart.strName.c_str());
+
+      switch (FormPart.eSource)
+      {
+      case SOURCE_CONTENT:
+         if (res == CURLE_OK)
+            res = curl_mime_data(pMimePart, FormPart.strContent.data(), FormPart.strContent.size());
+         break;
+
+      case SOURCE_BUFFER:
+         m_vecCursors.push_back({ &FormPart, 0 });
+         if (res == CURLE_OK)
+            res = curl_mime_data_cb(pMimePart, FormPart.iSize, &MimeUpload::ReadBufferCallback,
+                                    &MimeUpload::SeekBufferCallback, nullptr, &m_vecCursors.back());
+         break;
+
+      case SOURCE_FILE:
+         // also sets the file name to the file's one
+         if (res == CURLE_OK)
+            res = curl_mime_filedata(pMimePart, FormPart.strContent.c_str());
+         break;
+
+      case SOURCE_STREAM:
+         m_vecCursors.push_back({ &FormPart, 0 });
+         if (res == CURLE_OK)
+            res = curl_mime_data_cb(pMimePart, FormPart.iSize, &MimeUpload::ReadStreamCallback,
+                                    &MimeUpload::SeekStreamCallback, nullptr, &m_vecCursors.back());
+         break;
+      }
+
+      if (res == CURLE_OK && !FormPart.strFileName.empty())
+         res = curl_mime_filename(pMimePart, FormPart.strFileName.c_str());
+
+      if (res == CURLE_OK && !FormPart.strContentType.empty())
+         res = curl_mime_type(pMimePart, FormPart.strContentType.c_str());
+
+      if (res == CURLE_OK && !FormPart.vecHeaders.empty())
+      {
+         struct curl_slist* pHeaders = nullptr;
+         for (const std::string& strHeader : FormPart.vecHeaders)
+            pHeaders = curl_slist_append(pHeaders, strHeader.c_str());
+
+         // the list is owned by the part
+         res = curl_mime_headers(pMimePart, pHeaders, 1);
+      }
+
+      if (res != CURLE_OK)
+         return res;
+   }
+
+   return CURLE_OK;
+}
+
+/**
+ * @brief read callback of a part sent from a caller's buffer
+ */
+size_t CHTTPMultipartForm::MimeUpload::ReadBufferCallback(char* pBuffer, size_t usSize, size_t usCount, void* pArg)
+{
+   PartCursor* pCursor = reinterpret_cast<PartCursor*>(pArg);
+
+   const size_t usCopySize = static_cast<size_t>(std::min<curl_off_t>(
+      static_cast<curl_off_t>(usSize * usCount), pCursor->pPart->iSize - pCursor->iOffset));
+
+   std::memcpy(pBuffer, pCursor->pPart->pData + pCursor->iOffset, usCopySize);
+   pCursor->iOffset += usCopySize;
+
+   return usCopySize;
+}
+
+/**
+ * @brief seek callback of a part sent from a caller's buffer (rewind on a redirection or
+ * an authentication)
+ */
+int CHTTPMultipartForm::MimeUpload::SeekBufferCallback(void* pArg, curl_off_t iOffset, int iOrigin)
+{
+   PartCursor* pCursor = reinterpret_cast<PartCursor*>(pArg);
+
+   switch (iOrigin)
+   {
+   case SEEK_END:
+      iOffset += pCursor->pPart->iSize;
+      break;
+   case SEEK_CUR:
+      iOffset += pCursor->iOffset;
+      break;
+   }
+
+   if (iOffset < 0 || iOffset > pCursor->pPart->iSize)
+      return CURL_SEEKFUNC_FAIL;
+
+   pCursor->iOffset = iOffset;
+   return CURL_SEEKFUNC_OK;
+}
+
+/**
+ * @brief read callback of a part produced on demand
+ */
+size_t CHTTPMultipartForm::MimeUpload::ReadStreamCallback(char* pBuffer, size_t usSize, size_t usCount, void* pArg)
+{
+   PartCursor* pCursor = reinterpret_cast<PartCursor*>(pArg);
+
+   const size_t usProduced = pCursor->pPart->fnProducer(pBuffer, usSize * usCount);
+   if (usProduced != CURL_READFUNC_PAUSE && usProduced != CURL_READFUNC_ABORT)
+      pCursor->iOffset += usProduced;
+
+   return usProduced;
+}
+
+/**
+ * @brief seek callback of a part produced on demand : it can only be "rewound" before
+ * anything was produced
+ */
+int CHTTPMultipartForm::MimeUpload::SeekStreamCallback(void* pArg, curl_off_t iOffset, int iOrigin)
+{
+   PartCursor* pCursor = reinterpret_cast<PartCursor*>(pArg);
+
+   if (iOffset == 0 && iOrigin == SEEK_SET && pCursor->iOffset == 0)
+      return CURL_SEEKFUNC_OK;
+
+   return CURL_SEEKFUNC_CANTSEEK;
+}
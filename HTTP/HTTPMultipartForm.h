@@ -0,0 +1,123 @@
+/*
+ * @file HTTPMultipartForm.h
+ * @brief multipart/form-data body built on libcurl's MIME API
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPMULTIPARTFORM_H_
+#define INCLUDE_HTTPMULTIPARTFORM_H_
+
+#include <cstddef>         // std::size_t
+#include <curl/curl.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* Describes the parts of a multipart/form-data body (see CHTTPClient::Post and
+ * CHTTPClient::UploadForm). A part's content is either :
+ * - a copied string (AddContent),
+ * - a caller's buffer sent without being copied (AddBuffer), it must remain valid until
+ *   the request returns,
+ * - a file read from disk while it is sent (AddFile),
+ * - a producer called while the part is sent (AddStream), its size may be unknown.
+ * Only the copied strings are held in memory, so parts of any size can be uploaded. When
+ * the size of a streamed part is unknown, the body is sent with "Transfer-Encoding: chunked".
+ *
+ * The Add methods return the form so calls can be chained, AddPartHeader applies to the
+ * last added part. */
+class CHTTPMultipartForm
+{
+public:
+   /* same contract as CHTTPClient::ProducerFnCallback : returns the number of bytes written
+    * in pszBuffer, 0 once the part is complete, CHTTPClient::PRODUCER_PAUSE or
+    * CHTTPClient::PRODUCER_ABORT */
+   typedef std::function<size_t(char* pszBuffer, size_t usSize)> ProducerFnCallback;
+
+   CHTTPMultipartForm();
+   virtual ~CHTTPMultipartForm();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPMultipartForm(const CHTTPMultipartForm& Copy) = delete;
+   CHTTPMultipartForm& operator=(const CHTTPMultipartForm& Copy) = delete;
+
+   CHTTPMultipartForm& AddContent(const std::string& strName, const std::string& strValue,
+                                  const std::string& strContentType = std::string());
+   CHTTPMultipartForm& AddBuffer(const std::string& strName, const void* pData, const size_t usSize,
+                                 const std::string& strFileName = std::string(),
+                                 const std::string& strContentType = std::string());
+   CHTTPMultipartForm& AddFile(const std::string& strName, const std::string& strFilePath,
+                               const std::string& strFileName = std::string(),
+                               const std::string& strContentType = std::string());
+   CHTTPMultipartForm& AddStream(const std::string& strName, const ProducerFnCallback& fnProducer,
+                                 const curl_off_t iLength = -1,
+                                 const std::string& strFileName = std::string(),
+                                 const std::string& strContentType = std::string());
+   CHTTPMultipartForm& AddPartHeader(const std::string& strHeader);
+
+   inline void Clear() { m_vecParts.clear(); }
+   inline const bool IsEmpty() const { return m_vecParts.empty(); }
+   inline const size_t GetPartsCount() const { return m_vecParts.size(); }
+   const bool HasStreamedParts() const;
+
+protected:
+   enum PartSource
+   {
+      SOURCE_CONTENT,
+      SOURCE_BUFFER,
+      SOURCE_FILE,
+      SOURCE_STREAM
+   };
+
+   struct Part
+   {
+      PartSource               eSource;
+      std::string              strName;
+      std::string              strFileName;
+      std::string              strContentType;
+      std::vector<std::string> vecHeaders;
+      std::string              strContent;   // copied content or file path
+      const char*              pData;        // buffer
+      curl_off_t               iSize;        // size of the buffer or of the stream (-1 if unknown)
+      ProducerFnCallback       fnProducer;
+   };
+
+   Part& AddPart(const PartSource eSource, const std::string& strName,
+                 const std::string& strFileName, const std::string& strContentType);
+
+   std::vector<Part> m_vecParts;
+
+public:
+   /* libcurl's MIME structure of a form and the read positions of its parts, it is built
+    * for a transfer and must outlive it. The form must not be modified meanwhile. */
+   class MimeUpload
+   {
+   public:
+      MimeUpload();
+      ~MimeUpload();
+
+      // copy constructor and assignment operator are disabled
+      MimeUpload(const MimeUpload& Copy) = delete;
+      MimeUpload& operator=(const MimeUpload& Copy) = delete;
+
+      const CURLcode Build(const CHTTPMultipartForm& Form, CURL* pCurl);
+      inline curl_mime* GetMime() const { return m_pMime; }
+
+   protected:
+      struct PartCursor
+      {
+         const Part* pPart;
+         curl_off_t  iOffset;   // bytes read
+      };
+
+      static size_t ReadBufferCallback(char* pBuffer, size_t usSize, size_t usCount, void* pArg);
+      static int SeekBufferCallback(void* pArg, curl_off_t iOffset, int iOrigin);
+      static size_t ReadStreamCallback(char* pBuffer, size_t usSize, size_t usCount, void* pArg);
+      static int SeekStreamCallback(void* pArg, curl_off_t iOffset, int iOrigin);
+
+      curl_mime*              m_pMime;
+      std::vector<PartCursor> m_vecCursors;
+   };
+};
+
+#endif
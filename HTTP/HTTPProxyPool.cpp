@@ -0,0 +1,305 @@
+/**
+* @file HTTPProxyPool.cpp
+* @brief implementation of the pool of proxies
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPProxyPool.h"
+
+#include <algorithm>
+
+const size_t CHTTPProxyPool::NO_PROXY;
+
+/**
+ * @brief constructor of the pool, it holds no proxy
+ *
+ * @param [in] lRetryDelay time an unreachable proxy is avoided (in seconds)
+ * @param [in] lProbeTimeoutMs connection timeout of the health checks (in milliseconds)
+ */
+CHTTPProxyPool::CHTTPProxyPool(const long lRetryDelay /* = 30 */, const long lProbeTimeoutMs /* = 2000 */) :
+   m_usNext(0),
+   m_RetryDelay(std::chrono::seconds(lRetryDelay)),
+   m_lProbeTimeoutMs(lProbeTimeoutMs),
+   m_bStopping(false)
+{
+}
+
+/**
+ * @brief destructor of the pool, stops the health checks
+ */
+CHTTPProxyPool::~CHTTPProxyPool()
+{
+   StopHealthChecks();
+}
+
+/**
+ * @brief adds a proxy to the pool, must not be called while the pool is used
+ *
+ * @param [in] strProxy proxy URL, e.g. "http://host:3128" or "socks5h://host:1080"
+ *
+ * @retval true   The proxy is added.
+ * @retval false  The proxy has no host.
+ */
+const bool CHTTPProxyPool::AddProxy(const std::string& strProxy)
+{
+   std::unique_ptr<Proxy> pProxy(new Proxy);
+   size_t usScheme = strProxy.find("://");
+   if (usScheme == std::string::npos)
+   {
+      pProxy->strProxy = "http://" + strProxy;
+      usScheme = 4;
+   }
+   else
+      pProxy->strProxy = strProxy;
+
+   // host and port of the proxy, for the health checks
+   const std::string& strUrl = pProxy->strProxy;
+   size_t usStart = usScheme + 3;
+   const size_t usEnd = std::min(strUrl.find('/', usStart), strUrl.size());
+   const size_t usAt = strUrl.rfind('@', usEnd);
+   if (usAt != std::string::npos && usAt >= usStart)
+      usStart = usAt + 1;
+   if (usStart >= usEnd)
+      return false;
+
+   const std::string strHost = strUrl.substr(usStart, usEnd - usStart);
+   const size_t usPort = strHost.rfind(':');
+   const bool bHasPort = usPort != std::string::npos && strHost.find(']', usPort) == std::string::npos;
+
+   // libcurl's default ports
+   const char* pszDefaultPort = (strUrl.compare(0, 8, "https://") == 0) ? ":443" : ":1080";
+   pProxy->strProbeUrl = "http://" + strHost + ((bHasPort) ? "" : pszDefaultPort) + "/";
+
+   m_vecProxies.push_back(std::move(pProxy));
+   return true;
+}
+
+/**
+ * @brief sends the next transfer of a handle through the healthy proxy with the fewest
+ * transfers in progress
+ *
+ * @param [in] pCurl handle of the transfer
+ *
+ * @retval index of the proxy, to pass to Release once the transfer is done, NO_PROXY if
+ * the pool is empty
+ */
+const size_t CHTTPProxyPool::Acquire(CURL* pCurl)
+{
+   if (m_vecProxies.empty())
+      return NO_PROXY;
+
+   const size_t usCount = m_vecProxies.size();
+   const size_t usFirst = m_usNext.fetch_add(1, std::memory_order_relaxed);
+   const long long llNow = Clock::now().time_since_epoch().count();
+
+   // least loaded healthy proxy, otherwise the first one to be retried
+   size_t usIndex = NO_PROXY;
+   size_t usLeastActive = 0;
+   size_t usFirstRetried = usFirst % usCount;
+   for (size_t usTry = 0; usTry < usCount; ++usTry)
+   {
+      const size_t usCandidate = (usFirst + usTry) % usCount;
+      const Proxy& Candidate = *m_vecProxies[usCandidate];
+
+      const long long llRetryAt = Candidate.llRetryAt.load(std::memory_order_relaxed);
+      if (llRetryAt > llNow)
+      {
+         if (llRetryAt < m_vecProxies[usFirstRetried]->llRetryAt.load(std::memory_order_relaxed))
+            usFirstRetried = usCandidate;
+         continue;
+      }
+
+      const size_t usActive = Candidate.usActive.load(std::memory_order_relaxed);
+      if (usIndex == NO_PROXY || usActive < usLeastActive)
+      {
+         usIndex = usCandidate;
+         usLeastActive = usActive;
+      }
+   }
+   if (usIndex == NO_PROXY)
+      usIndex = usFirstRetried;
+
+   Proxy& Selected = *m_vecProxies[usIndex];
+   ++Selected.usActive;
+   ++Selected.usTransfers;
+
+   curl_easy_setopt(pCurl, CURLOPT_PROXY, Selected.strProxy.c_str());
+
+   return usIndex;
+}
+
+/**
+ * @brief ends a transfer through a proxy, the proxy is unhealthy if it couldn't be reached
+ *
+ * @param [in] usIndex index returned by Acquire
+ * @param [in] pCurl handle of the transfer
+ * @param [in] eResult result of the transfer
+ */
+void CHTTPProxyPool::Release(const size_t usIndex, CURL* pCurl, const CURLcode eResult)
+{
+   if (usIndex >= m_vecProxies.size())
+      return;
+
+   Proxy& Released = *m_vecProxies[usIndex];
+   --Released.usActive;
+
+   if (IsProxyFailure(pCurl, eResult))
+      MarkUnhealthy(Released);
+}
+
+/**
+ * @brief checks the proxies : connects to each of them (without sending anything)
+ *
+ * @retval number of healthy proxies
+ */
+const size_t CHTTPProxyPool::Probe()
+{
+   size_t usHealthy = 0;
+
+   for (const std::unique_ptr<Proxy>& pProxy : m_vecProxies)
+   {
+      CURL* pCurl = curl_easy_init();
+      if (pCurl == nullptr)
+         continue;
+
+      curl_easy_setopt(pCurl, CURLOPT_URL, pProxy->strProbeUrl.c_str());
+      curl_easy_setopt(pCurl, CURLOPT_CONNECT_ONLY, 1L);
+      curl_easy_setopt(pCurl, CURLOPT_CONNECTTIMEOUT_MS, m_lProbeTimeoutMs);
+      curl_easy_setopt(pCurl, CURLOPT_NOSIGNAL, 1L);
+      curl_easy_setopt(pCurl, CURLOPT_PROXY, "");    // not the environment's proxy
+
+      const CURLcode eResult = curl_easy_perform(pCurl);
+      curl_easy_cleanup(pCurl);
+
+      if (eResult == CURLE_OK)
+      {
+         pProxy->llRetryAt = 0;
+         ++usHealthy;
+      }
+      else
+         MarkUnhealthy(*pProxy);
+   }
+
+   return usHealthy;
+}
+
+/**
+ * @brief starts checking the proxies periodically in a background thread
+ *
+ * @param [in] lInterval time between two checks (in seconds)
+ */
+void CHTTPProxyPool::StartHealthChecks(const long lInterval)
+{
+   StopHealthChecks();
+
+   std::lock_guard<std::mutex> Lock(m_mtxHealth);
+   m_bStopping = false;
+   m_HealthThread = std::thread(&CHTTPProxyPool::HealthLoop, this, std::chrono::seconds(lInterval));
+}
+
+/**
+ * @brief stops the health checks, waits for the current check to finish
+ */
+void CHTTPProxyPool::StopHealthChecks()
+{
+   {
+      std::lock_guard<std::mutex> Lock(m_mtxHealth);
+      m_bStopping = true;
+   }
+   m_cvHealth.notify_all();
+
+   if (m_HealthThread.joinable())
+      m_HealthThread.join();
+}
+
+/**
+ * @brief returns the counters of each proxy, in the order they were added
+ */
+const std::vector<CHTTPProxyPool::ProxyStats> CHTTPProxyPool::GetStats() const
+{
+   const long long llNow = Clock::now().time_since_epoch().count();
+
+   std::vector<ProxyStats> vecStats(m_vecProxies.size());
+   for (size_t usIndex = 0; usIndex < m_vecProxies.size(); ++usIndex)
+   {
+      const Proxy& Counted = *m_vecProxies[usIndex];
+      ProxyStats& Stats = vecStats[usIndex];
+      Stats.strProxy = Counted.strProxy;
+      Stats.usActive = Counted.usActive;
+      Stats.usTransfers = Counted.usTransfers;
+      Stats.usFailures = Counted.usFailures;
+      Stats.bHealthy = Counted.llRetryAt <= llNow;
+   }
+
+   return vecStats;
+}
+
+/**
+ * @brief tells whether a transfer failed because its proxy couldn't be reached : nothing
+ * was sent to the server, the request can be sent again through another proxy. A proxy
+ * that answered about the server (e.g. SOCKS "host unreachable") was reached.
+ *
+ * @param [in] pCurl handle of the transfer
+ * @param [in] eResult result of the transfer
+ */
+const bool CHTTPProxyPool::IsProxyFailure(CURL* pCurl, const CURLcode eResult)
+{
+   if (eResult == CURLE_COULDNT_RESOLVE_PROXY)
+      return true;
+
+   // an HTTP proxy that answered the CONNECT
+   if (eResult == CURLE_COULDNT_CONNECT)
+   {
+      long lConnectCode = 0;
+      curl_easy_getinfo(pCurl, CURLINFO_HTTP_CONNECTCODE, &lConnectCode);
+      return lConnectCode == 0;
+   }
+
+#if LIBCURL_VERSION_NUM >= 0x074900
+   if (eResult == CURLE_PROXY)
+   {
+      long lProxyError = CURLPX_OK;
+      curl_easy_getinfo(pCurl, CURLINFO_PROXY_ERROR, &lProxyError);
+      switch (lProxyError)
+      {
+      // the SOCKS proxy couldn't reach the server
+      case CURLPX_REPLY_CONNECTION_REFUSED:
+      case CURLPX_REPLY_HOST_UNREACHABLE:
+      case CURLPX_REPLY_NETWORK_UNREACHABLE:
+      case CURLPX_REPLY_TTL_EXPIRED:
+      case CURLPX_REPLY_GENERAL_SERVER_FAILURE:  // also a failed resolution of the server
+      case CURLPX_REPLY_NOT_ALLOWED:
+      case CURLPX_REQUEST_FAILED:                // SOCKS4 : request rejected
+      // the server's name couldn't be resolved locally (socks4://, socks5://)
+      case CURLPX_RESOLVE_HOST:
+         return false;
+      default:
+         return true;
+      }
+   }
+#endif
+
+   return false;
+}
+
+void CHTTPProxyPool::MarkUnhealthy(Proxy& Unhealthy)
+{
+   ++Unhealthy.usFailures;
+   Unhealthy.llRetryAt = (Clock::now() + m_RetryDelay).time_since_epoch().count();
+}
+
+/**
+ * @brief body of the health checks' thread
+ */
+void CHTTPProxyPool::HealthLoop(const std::chrono::seconds Interval)
+{
+   std::unique_lock<std::mutex> Lock(m_mtxHealth);
+   while (!m_bStopping)
+   {
+      Lock.unlock();
+      Probe();
+      Lock.lock();
+
+      m_cvHealth.wait_for(Lock, Interval, [this]() { return m_bStopping; });
+   }
+}
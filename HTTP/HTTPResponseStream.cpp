@@ -0,0 +1,173 @@
+/**
+* @file HTTPResponseStream.cpp
+* @brief implementation of the bounded response body buffer
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPResponseStream.h"
+
+#include <algorithm>
+#include <cstring>         // memcpy
+
+/**
+ * @brief constructor of the stream
+ *
+ * @param [in] usCapacity maximum number of bytes buffered (at least CURL_MAX_WRITE_SIZE)
+ */
+CHTTPResponseStream::CHTTPResponseStream(const size_t usCapacity /* = 4 * CURL_MAX_WRITE_SIZE */) :
+   m_vecBuffer(std::max<size_t>(usCapacity, CURL_MAX_WRITE_SIZE)),
+   m_usHead(0),
+   m_usSize(0),
+   m_usPending(0),
+   m_bFinished(false),
+   m_bSuccess(false)
+{
+}
+
+/**
+ * @brief destructor of the stream
+ */
+CHTTPResponseStream::~CHTTPResponseStream()
+{
+}
+
+/**
+ * @brief reads the received body, blocks until data is available or the transfer is done
+ * the transfer is resumed if it was paused and enough room has been made
+ *
+ * @param [out] pszBuffer buffer receiving the data
+ * @param [in] usSize size of pszBuffer
+ *
+ * @return number of bytes read, 0 once the whole body has been read (check IsSuccessful())
+ */
+size_t CHTTPResponseStream::Read(char* pszBuffer, const size_t usSize)
+{
+   ResumeFnCallback fnResume;
+   size_t usRead = 0;
+   {
+      std::unique_lock<std::mutex> lock(m_mtxBuffer);
+      m_cvReadable.wait(lock, [this]() { return m_usSize > 0 || m_bFinished; });
+
+      const size_t usCapacity = m_vecBuffer.size();
+      while (usRead < usSize && m_usSize > 0)
+      {
+         // contiguous part of the ring
+         const size_t usCopySize = std::min(usSize - usRead, std::min(m_usSize, usCapacity - m_usHead));
+         std::memcpy(pszBuffer + usRead, &m_vecBuffer[m_usHead], usCopySize);
+
+         m_usHead = (m_usHead + usCopySize) % usCapacity;
+         m_usSize -= usCopySize;
+         usRead += usCopySize;
+      }
+
+      // the refused block fits now : resume the transfer
+      if (m_usPending > 0 && usCapacity - m_usSize >= m_usPending)
+      {
+         m_usPending = 0;
+         fnResume = m_fnResume;
+      }
+   }
+
+   if (fnResume)
+      fnResume();
+
+   return usRead;
+}
+
+/**
+ * @brief returns true once the transfer is done (all the body may not have been read yet)
+ */
+const bool CHTTPResponseStream::IsFinished() const
+{
+   std::lock_guard<std::mutex> lock(m_mtxBuffer);
+   return m_bFinished;
+}
+
+/**
+ * @brief returns true if the transfer is done and succeeded
+ */
+const bool CHTTPResponseStream::IsSuccessful() const
+{
+   std::lock_guard<std::mutex> lock(m_mtxBuffer);
+   return m_bFinished && m_bSuccess;
+}
+
+/**
+ * @brief returns the number of bytes received and not read yet
+ */
+const size_t CHTTPResponseStream::GetSize() const
+{
+   std::lock_guard<std::mutex> lock(m_mtxBuffer);
+   return m_usSize;
+}
+
+/**
+ * @brief empties the stream before a new transfer
+ *
+ * @param [in] fnResume callback resuming the paused transfer, called from Read()
+ */
+void CHTTPResponseStream::Open(const ResumeFnCallback& fnResume)
+{
+   std::lock_guard<std::mutex> lock(m_mtxBuffer);
+   m_usHead = 0;
+   m_usSize = 0;
+   m_usPending = 0;
+   m_bFinished = false;
+   m_bSuccess = false;
+   m_fnResume = fnResume;
+}
+
+/**
+ * @brief stores a block of the body, all or nothing
+ *
+ * @param [in] pData block delivered by libcurl
+ * @param [in] usSize size of the block
+ *
+ * @retval true   The block was stored.
+ * @retval false  Not enough room : the transfer must be paused, Read() will resume it.
+ */
+const bool CHTTPResponseStream::Write(const char* pData, const size_t usSize)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mtxBuffer);
+
+      const size_t usCapacity = m_vecBuffer.size();
+      if (usCapacity - m_usSize < usSize)
+      {
+         m_usPending = usSize;
+         return false;
+      }
+
+      size_t usWritten = 0;
+      size_t usTail = (m_usHead + m_usSize) % usCapacity;
+      while (usWritten < usSize)
+      {
+         const size_t usCopySize = std::min(usSize - usWritten, usCapacity - usTail);
+         std::memcpy(&m_vecBuffer[usTail], pData + usWritten, usCopySize);
+
+         usTail = (usTail + usCopySize) % usCapacity;
+         usWritten += usCopySize;
+      }
+      m_usSize += usSize;
+   }
+   m_cvReadable.notify_one();
+
+   return true;
+}
+
+/**
+ * @brief marks the end of the transfer, wakes up the blocked readers
+ *
+ * @param [in] bSuccess whether the transfer succeeded
+ */
+void CHTTPResponseStream::Close(const bool bSuccess)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mtxBuffer);
+      m_bFinished = true;
+      m_bSuccess = bSuccess;
+      m_usPending = 0;
+      m_fnResume = nullptr;
+   }
+   m_cvReadable.notify_all();
+}
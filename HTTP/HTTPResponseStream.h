@@ -0,0 +1,63 @@
+/*
+ * @file HTTPResponseStream.h
+ * @brief bounded buffer receiving a response body, the transfer is paused while it is full
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPRESPONSESTREAM_H_
+#define INCLUDE_HTTPRESPONSESTREAM_H_
+
+#include <condition_variable>
+#include <cstddef>         // std::size_t
+#include <curl/curl.h>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/* A response body received in this stream (see CHTTPClient::Get) is not accumulated : it
+ * is written in a ring buffer of fixed capacity and read by a consumer, usually from
+ * another thread. When the buffer can't hold the data delivered by libcurl, the transfer
+ * is paused (CURL_WRITEFUNC_PAUSE) and it is resumed once the consumer has drained enough
+ * data, so the memory used by the transfer stays bounded whatever the speed of the server.
+ *
+ * The capacity is at least CURL_MAX_WRITE_SIZE, the largest block libcurl delivers at once. */
+class CHTTPResponseStream
+{
+public:
+   // Public definitions
+   typedef std::function<void()> ResumeFnCallback;
+
+   explicit CHTTPResponseStream(const size_t usCapacity = 4 * CURL_MAX_WRITE_SIZE);
+   virtual ~CHTTPResponseStream();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPResponseStream(const CHTTPResponseStream& Copy) = delete;
+   CHTTPResponseStream& operator=(const CHTTPResponseStream& Copy) = delete;
+
+   // Consumer side (any thread)
+   size_t Read(char* pszBuffer, const size_t usSize);
+   const bool IsFinished() const;
+   const bool IsSuccessful() const;
+   const size_t GetSize() const;
+   inline const size_t GetCapacity() const { return m_vecBuffer.size(); }
+
+   // Transfer side (thread performing the request)
+   void Open(const ResumeFnCallback& fnResume);
+   const bool Write(const char* pData, const size_t usSize);
+   void Close(const bool bSuccess);
+
+protected:
+   std::vector<char>         m_vecBuffer;
+   size_t                    m_usHead;      // position of the first byte to read
+   size_t                    m_usSize;      // number of bytes to read
+   size_t                    m_usPending;   // size of the block refused by Write (0 : not paused)
+   bool                      m_bFinished;
+   bool                      m_bSuccess;
+   ResumeFnCallback          m_fnResume;
+
+   mutable std::mutex        m_mtxBuffer;
+   std::condition_variable   m_cvReadable;
+};
+
+#endif
@@ -0,0 +1,194 @@
+/**
+* @file HTTPSocketProfile.cpp
+* @brief implementation of the socket tuning profile
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPSocketProfile.h"
+
+#ifdef LINUX
+#include <netinet/in.h>    // IPPROTO_TCP, IP_TOS, IPV6_TCLASS
+#include <netinet/tcp.h>   // TCP_KEEPCNT
+#include <sys/socket.h>
+#endif
+
+#ifdef WINDOWS
+#include <ws2tcpip.h>
+#endif
+
+/**
+ * @brief constructor of the profile, the system's defaults (and libcurl's TCP_NODELAY)
+ */
+CHTTPSocketProfile::CHTTPSocketProfile() :
+   m_bNoDelay(true),
+   m_lKeepIdle(0),
+   m_lKeepInterval(0),
+   m_iKeepProbes(0),
+   m_iSendBuffer(0),
+   m_iReceiveBuffer(0),
+   m_iTos(-1),
+   m_iBusyPollUs(0),
+   m_usFailures(0)
+{
+}
+
+/**
+ * @brief destructor of the profile
+ */
+CHTTPSocketProfile::~CHTTPSocketProfile()
+{
+}
+
+/**
+ * @brief returns the profile of the latency-sensitive requests : Nagle's algorithm disabled,
+ * dead connections detected in about a minute, low delay TOS, busy polling
+ */
+std::shared_ptr<const CHTTPSocketProfile> CHTTPSocketProfile::LowLatency()
+{
+   static const std::shared_ptr<const CHTTPSocketProfile> s_pProfile = []()
+   {
+      std::shared_ptr<CHTTPSocketProfile> pProfile = std::make_shared<CHTTPSocketProfile>();
+      pProfile->SetNoDelay(true).SetKeepAlive(30, 10, 3).SetTypeOfService(0x10).SetBusyPoll(50);
+      return pProfile;
+   }();
+   return s_pProfile;
+}
+
+/**
+ * @brief returns the profile of the bulk transfers : large buffers (for the TCP window),
+ * throughput TOS, long keepalive
+ */
+std::shared_ptr<const CHTTPSocketProfile> CHTTPSocketProfile::Bulk()
+{
+   static const std::shared_ptr<const CHTTPSocketProfile> s_pProfile = []()
+   {
+      std::shared_ptr<CHTTPSocketProfile> pProfile = std::make_shared<CHTTPSocketProfile>();
+      pProfile->SetBufferSizes(4 * 1024 * 1024, 4 * 1024 * 1024).SetTypeOfService(0x08).SetKeepAlive(120, 30);
+      return pProfile;
+   }();
+   return s_pProfile;
+}
+
+/**
+ * @brief enables or disables Nagle's algorithm (TCP_NODELAY, libcurl disables it by default)
+ */
+CHTTPSocketProfile& CHTTPSocketProfile::SetNoDelay(const bool bNoDelay)
+{
+   m_bNoDelay = bNoDelay;
+   return *this;
+}
+
+/**
+ * @brief enables the TCP keepalive probes
+ *
+ * @param [in] lIdleSec idle time before the first probe, 0 to disable keepalive
+ * @param [in] lIntervalSec interval between the probes
+ * @param [in] iProbes unanswered probes before the connection is dropped, 0 for the system's
+ * default
+ */
+CHTTPSocketProfile& CHTTPSocketProfile::SetKeepAlive(const long lIdleSec, const long lIntervalSec,
+                                                     const int iProbes /* = 0 */)
+{
+   m_lKeepIdle = lIdleSec;
+   m_lKeepInterval = lIntervalSec;
+   m_iKeepProbes = iProbes;
+   return *this;
+}
+
+/**
+ * @brief sets the sizes of the kernel's buffers (SO_SNDBUF, SO_RCVBUF) before the connection
+ * so the TCP window can grow accordingly, 0 to keep the system's default (and autotuning)
+ */
+CHTTPSocketProfile& CHTTPSocketProfile::SetBufferSizes(const int iSendBuffer, const int iReceiveBuffer)
+{
+   m_iSendBuffer = iSendBuffer;
+   m_iReceiveBuffer = iReceiveBuffer;
+   return *this;
+}
+
+/**
+ * @brief sets the type of service (IP_TOS, or the traffic class on IPv6), -1 to keep the
+ * system's default
+ */
+CHTTPSocketProfile& CHTTPSocketProfile::SetTypeOfService(const int iTos)
+{
+   m_iTos = iTos;
+   return *this;
+}
+
+/**
+ * @brief sets the time the receive calls busy poll the device queue (SO_BUSY_POLL, Linux),
+ * 0 to disable it
+ */
+CHTTPSocketProfile& CHTTPSocketProfile::SetBusyPoll(const int iBusyPollUs)
+{
+   m_iBusyPollUs = iBusyPollUs;
+   return *this;
+}
+
+/**
+ * @brief sets the options of the profile on a handle, they are applied to its next
+ * connections. The profile must outlive the handle's transfers.
+ */
+void CHTTPSocketProfile::Apply(CURL* pCurl) const
+{
+   curl_easy_setopt(pCurl, CURLOPT_TCP_NODELAY, (m_bNoDelay) ? 1L : 0L);
+
+   curl_easy_setopt(pCurl, CURLOPT_TCP_KEEPALIVE, (m_lKeepIdle > 0) ? 1L : 0L);
+   if (m_lKeepIdle > 0)
+   {
+      curl_easy_setopt(pCurl, CURLOPT_TCP_KEEPIDLE, m_lKeepIdle);
+      curl_easy_setopt(pCurl, CURLOPT_TCP_KEEPINTVL, (m_lKeepInterval > 0) ? m_lKeepInterval : m_lKeepIdle);
+   }
+
+   curl_easy_setopt(pCurl, CURLOPT_SOCKOPTFUNCTION, &CHTTPSocketProfile::SockoptCallback);
+   curl_easy_setopt(pCurl, CURLOPT_SOCKOPTDATA, const_cast<CHTTPSocketProfile*>(this));
+}
+
+/**
+ * @brief called by libcurl on each new socket, before it connects
+ */
+int CHTTPSocketProfile::SockoptCallback(void* pUserData, curl_socket_t Socket, curlsocktype ePurpose)
+{
+   const CHTTPSocketProfile* pProfile = static_cast<const CHTTPSocketProfile*>(pUserData);
+
+   if (ePurpose != CURLSOCKTYPE_IPCXN || pProfile == nullptr)
+      return CURL_SOCKOPT_OK;
+
+   struct sockaddr_storage Address;
+   socklen_t iLength = sizeof(Address);
+   const int iFamily = (getsockname(Socket, reinterpret_cast<struct sockaddr*>(&Address), &iLength) == 0)
+                       ? Address.ss_family : AF_UNSPEC;
+
+   if (pProfile->m_iSendBuffer > 0)
+      pProfile->SetOption(Socket, SOL_SOCKET, SO_SNDBUF, pProfile->m_iSendBuffer);
+   if (pProfile->m_iReceiveBuffer > 0)
+      pProfile->SetOption(Socket, SOL_SOCKET, SO_RCVBUF, pProfile->m_iReceiveBuffer);
+
+#ifdef SO_BUSY_POLL
+   if (pProfile->m_iBusyPollUs > 0)
+      pProfile->SetOption(Socket, SOL_SOCKET, SO_BUSY_POLL, pProfile->m_iBusyPollUs);
+#endif
+
+   // IP and TCP options (not for Unix domain sockets)
+   if (pProfile->m_iTos >= 0 && iFamily == AF_INET)
+      pProfile->SetOption(Socket, IPPROTO_IP, IP_TOS, pProfile->m_iTos);
+#ifdef IPV6_TCLASS
+   else if (pProfile->m_iTos >= 0 && iFamily == AF_INET6)
+      pProfile->SetOption(Socket, IPPROTO_IPV6, IPV6_TCLASS, pProfile->m_iTos);
+#endif
+
+#ifdef TCP_KEEPCNT
+   if (pProfile->m_lKeepIdle > 0 && pProfile->m_iKeepProbes > 0 && (iFamily == AF_INET || iFamily == AF_INET6))
+      pProfile->SetOption(Socket, IPPROTO_TCP, TCP_KEEPCNT, pProfile->m_iKeepProbes);
+#endif
+
+   return CURL_SOCKOPT_OK;
+}
+
+void CHTTPSocketProfile::SetOption(const curl_socket_t Socket, const int iLevel, const int iName,
+                                   const int iValue) const
+{
+   if (setsockopt(Socket, iLevel, iName, reinterpret_cast<const char*>(&iValue), sizeof(iValue)) != 0)
+      ++m_usFailures;
+}
@@ -0,0 +1,74 @@
+/*
+ * @file HTTPSocketProfile.h
+ * @brief tuning of the sockets opened by libcurl (Nagle, keepalive, buffers, TOS...)
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPSOCKETPROFILE_H_
+#define INCLUDE_HTTPSOCKETPROFILE_H_
+
+#include <atomic>
+#include <cstddef>         // std::size_t
+#include <curl/curl.h>
+#include <memory>
+
+/* Settings applied to the sockets of the new connections of the sessions using the profile
+ * (see CHTTPClient::SetSocketProfile) : through libcurl's options (TCP_NODELAY, keepalive)
+ * and through CURLOPT_SOCKOPTFUNCTION before the socket connects (buffers, TOS, busy
+ * polling, keepalive probes count). A profile is built once then shared, read-only, by any
+ * number of sessions and threads.
+ *
+ * The settings of a connection are those of the profile active when it was opened : a
+ * connection reused by a request with another profile keeps them. The options that the
+ * system doesn't support are skipped, failed setsockopt calls are counted (GetFailures()),
+ * they don't fail the requests. The TCP options aren't applied to Unix domain sockets. */
+class CHTTPSocketProfile
+{
+public:
+   CHTTPSocketProfile();
+   virtual ~CHTTPSocketProfile();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPSocketProfile(const CHTTPSocketProfile& Copy) = delete;
+   CHTTPSocketProfile& operator=(const CHTTPSocketProfile& Copy) = delete;
+
+   // presets : latency-sensitive REST calls, bulk transfers (e.g. DownloadFile)
+   static std::shared_ptr<const CHTTPSocketProfile> LowLatency();
+   static std::shared_ptr<const CHTTPSocketProfile> Bulk();
+
+   CHTTPSocketProfile& SetNoDelay(const bool bNoDelay);
+   CHTTPSocketProfile& SetKeepAlive(const long lIdleSec, const long lIntervalSec, const int iProbes = 0);
+   CHTTPSocketProfile& SetBufferSizes(const int iSendBuffer, const int iReceiveBuffer);
+   CHTTPSocketProfile& SetTypeOfService(const int iTos);
+   CHTTPSocketProfile& SetBusyPoll(const int iBusyPollUs);
+
+   inline const bool GetNoDelay() const { return m_bNoDelay; }
+   inline const long GetKeepIdle() const { return m_lKeepIdle; }
+   inline const long GetKeepInterval() const { return m_lKeepInterval; }
+   inline const int GetKeepProbes() const { return m_iKeepProbes; }
+   inline const int GetSendBuffer() const { return m_iSendBuffer; }
+   inline const int GetReceiveBuffer() const { return m_iReceiveBuffer; }
+   inline const int GetTypeOfService() const { return m_iTos; }
+   inline const int GetBusyPoll() const { return m_iBusyPollUs; }
+   inline const size_t GetFailures() const { return m_usFailures; }
+
+   void Apply(CURL* pCurl) const;
+
+protected:
+   static int SockoptCallback(void* pUserData, curl_socket_t Socket, curlsocktype ePurpose);
+   void SetOption(const curl_socket_t Socket, const int iLevel, const int iName, const int iValue) const;
+
+   bool   m_bNoDelay;
+   long   m_lKeepIdle;                       // 0 : keepalive disabled
+   long   m_lKeepInterval;
+   int    m_iKeepProbes;                     // 0 : system default
+   int    m_iSendBuffer;                     // 0 : system default
+   int    m_iReceiveBuffer;
+   int    m_iTos;                            // -1 : system default
+   int    m_iBusyPollUs;                     // 0 : disabled
+
+   mutable std::atomic<size_t> m_usFailures;
+};
+
+#endif
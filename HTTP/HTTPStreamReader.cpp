@@ -0,0 +1,322 @@
+/**
+* @file HTTPStreamReader.cpp
+* @brief implementation of the line and Server-Sent Events readers
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPStreamReader.h"
+
+#include <cstring>         // memchr
+
+// LINE READER
+
+/**
+ * @brief constructor of the line reader
+ *
+ * @param [in] fnLine callback receiving the lines
+ * @param [in] usMaxLineLength lines longer than this stop the reading (0 : no limit)
+ */
+CHTTPLineReader::CHTTPLineReader(const LineFnCallback& fnLine, const size_t usMaxLineLength /* = 0 */) :
+   m_fnLine(fnLine),
+   m_usMaxLineLength(usMaxLineLength),
+   m_bSkipLF(false),
+   m_bStopped(false),
+   m_bLineTooLong(false),
+   m_usLines(0)
+{
+}
+
+/**
+ * @brief destructor of the line reader
+ */
+CHTTPLineReader::~CHTTPLineReader()
+{
+}
+
+/**
+ * @brief prepares the reader for a new body, the buffer is kept
+ */
+void CHTTPLineReader::Reset()
+{
+   m_strPending.clear();
+   m_bSkipLF = false;
+   m_bStopped = false;
+   m_bLineTooLong = false;
+   m_usLines = 0;
+}
+
+/**
+ * @brief splits the next chunk of the body into lines
+ *
+ * @param [in] pData chunk, it isn't referenced after the call
+ * @param [in] usSize size of the chunk
+ *
+ * @retval true   The chunk was read, its last line may be incomplete.
+ * @retval false  The reading was stopped (by the callback or a line too long).
+ */
+const bool CHTTPLineReader::Parse(const char* pData, const size_t usSize)
+{
+   if (m_bStopped)
+      return false;
+
+   const char* pStart = pData;
+   const char* pEnd = pData + usSize;
+
+   // "\r\n" split by the chunk boundary
+   if (m_bSkipLF && pStart < pEnd)
+   {
+      if (*pStart == '\n')
+         ++pStart;
+      m_bSkipLF = false;
+   }
+
+   while (pStart < pEnd)
+   {
+      const char* pLF = static_cast<const char*>(std::memchr(pStart, '\n', pEnd - pStart));
+      const char* pLimit = (pLF != nullptr) ? pLF : pEnd;
+      const char* pCR = static_cast<const char*>(std::memchr(pStart, '\r', pLimit - pStart));
+
+      const char* pEol = nullptr;
+      size_t usEolLength = 1;
+      if (pCR != nullptr)
+      {
+         pEol = pCR;
+         if (pCR + 1 == pLF)
+            usEolLength = 2;
+         else if (pCR + 1 == pEnd)
+            m_bSkipLF = true;
+      }
+      else
+         pEol = pLF;
+
+      if (pEol == nullptr)
+      {
+         // incomplete line : kept until the next chunk
+         if (m_usMaxLineLength > 0 && m_strPending.size() + (pEnd - pStart) > m_usMaxLineLength)
+         {
+            m_bLineTooLong = true;
+            m_bStopped = true;
+            return false;
+         }
+         m_strPending.append(pStart, pEnd - pStart);
+         break;
+      }
+
+      bool bContinue;
+      if (m_strPending.empty())
+         bContinue = DeliverLine(pStart, pEol - pStart);
+      else
+      {
+         m_strPending.append(pStart, pEol - pStart);
+         bContinue = DeliverLine(m_strPending.data(), m_strPending.size());
+         m_strPending.clear();
+      }
+
+      if (!bContinue)
+         return false;
+
+      pStart = pEol + usEolLength;
+   }
+
+   return true;
+}
+
+/**
+ * @brief signals the end of the body, delivers its last line if it has no terminator
+ *
+ * @retval true   The whole body was read.
+ * @retval false  The reading was stopped.
+ */
+const bool CHTTPLineReader::Finish()
+{
+   if (m_bStopped)
+      return false;
+
+   if (m_strPending.empty())
+      return true;
+
+   const bool bContinue = DeliverLine(m_strPending.data(), m_strPending.size());
+   m_strPending.clear();
+
+   return bContinue;
+}
+
+/**
+ * @brief delivers a complete line to the callback
+ */
+const bool CHTTPLineReader::DeliverLine(const char* pData, const size_t usLength)
+{
+   if (m_usMaxLineLength > 0 && usLength > m_usMaxLineLength)
+   {
+      m_bLineTooLong = true;
+      m_bStopped = true;
+      return false;
+   }
+
+   ++m_usLines;
+   if (m_fnLine && !m_fnLine(CHTTPTextView(pData, usLength)))
+      m_bStopped = true;
+
+   return !m_bStopped;
+}
+
+// SERVER-SENT EVENTS READER
+
+/**
+ * @brief constructor of the events reader
+ *
+ * @param [in] fnEvent callback receiving the events
+ * @param [in] usMaxLineLength lines longer than this stop the reading (0 : no limit)
+ */
+CHTTPEventReader::CHTTPEventReader(const EventFnCallback& fnEvent, const size_t usMaxLineLength /* = 0 */) :
+   m_fnEvent(fnEvent),
+   m_LineReader([this](const CHTTPTextView& Line) { return OnLine(Line); }, usMaxLineLength),
+   m_bHasData(false),
+   m_bFirstLine(true),
+   m_lRetryMs(3000),
+   m_bStopped(false),
+   m_usEvents(0)
+{
+}
+
+/**
+ * @brief destructor of the events reader
+ */
+CHTTPEventReader::~CHTTPEventReader()
+{
+}
+
+/**
+ * @brief prepares the reader for a new connection : the event being received is
+ * discarded, the last event id and the reconnection delay are kept
+ */
+void CHTTPEventReader::Reset()
+{
+   m_LineReader.Reset();
+   m_strType.clear();
+   m_strData.clear();
+   m_bHasData = false;
+   m_bFirstLine = true;
+}
+
+/**
+ * @brief parses the next chunk of the stream, the complete events are dispatched
+ *
+ * @param [in] pData chunk, it isn't referenced after the call
+ * @param [in] usSize size of the chunk
+ *
+ * @retval true   The chunk was read.
+ * @retval false  The reading was stopped.
+ */
+const bool CHTTPEventReader::Parse(const char* pData, const size_t usSize)
+{
+   if (IsStopped())
+      return false;
+
+   return m_LineReader.Parse(pData, usSize);
+}
+
+/**
+ * @brief processes a line of the stream
+ */
+const bool CHTTPEventReader::OnLine(const CHTTPTextView& Line)
+{
+   if (m_bStopped)
+      return false;
+
+   const char* pszLine = Line.pszData;
+   size_t usLength = Line.usLength;
+
+   // a byte order mark may start the stream
+   if (m_bFirstLine)
+   {
+      m_bFirstLine = false;
+      if (usLength >= 3 && std::memcmp(pszLine, "\xEF\xBB\xBF", 3) == 0)
+      {
+         pszLine += 3;
+         usLength -= 3;
+      }
+   }
+
+   if (usLength == 0)
+      return Dispatch();
+
+   // comment
+   if (pszLine[0] == ':')
+      return true;
+
+   const char* pColon = static_cast<const char*>(std::memchr(pszLine, ':', usLength));
+   const size_t usNameLength = (pColon != nullptr) ? pColon - pszLine : usLength;
+   const char* pszValue = pszLine + usLength;
+   size_t usValueLength = 0;
+   if (pColon != nullptr)
+   {
+      pszValue = pColon + 1;
+      usValueLength = usLength - usNameLength - 1;
+      if (usValueLength > 0 && *pszValue == ' ')
+      {
+         ++pszValue;
+         --usValueLength;
+      }
+   }
+
+   const CHTTPTextView Name(pszLine, usNameLength);
+   if (Name.Equals("data"))
+   {
+      m_strData.append(pszValue, usValueLength).push_back('\n');
+      m_bHasData = true;
+   }
+   else if (Name.Equals("event"))
+      m_strType.assign(pszValue, usValueLength);
+   else if (Name.Equals("id"))
+   {
+      // ids containing a null character are ignored
+      if (std::memchr(pszValue, '\0', usValueLength) == nullptr)
+         m_strLastEventId.assign(pszValue, usValueLength);
+   }
+   else if (Name.Equals("retry"))
+   {
+      long lRetryMs = 0;
+      size_t i = 0;
+      for (; i < usValueLength && pszValue[i] >= '0' && pszValue[i] <= '9'; ++i)
+         lRetryMs = lRetryMs * 10 + (pszValue[i] - '0');
+
+      if (usValueLength > 0 && i == usValueLength)
+         m_lRetryMs = lRetryMs;
+   }
+   // other fields are ignored
+
+   return true;
+}
+
+/**
+ * @brief dispatches the event received so far (on a blank line)
+ */
+const bool CHTTPEventReader::Dispatch()
+{
+   if (!m_bHasData)
+   {
+      m_strType.clear();
+      return true;
+   }
+
+   // the last '\n' isn't part of the data
+   m_strData.pop_back();
+
+   ServerEvent Event;
+   Event.Type = (m_strType.empty()) ? CHTTPTextView("message", 7) : CHTTPTextView(m_strType.data(), m_strType.size());
+   Event.Data = CHTTPTextView(m_strData.data(), m_strData.size());
+   Event.Id = CHTTPTextView(m_strLastEventId.data(), m_strLastEventId.size());
+
+   ++m_usEvents;
+   const bool bContinue = !m_fnEvent || m_fnEvent(Event);
+
+   m_strType.clear();
+   m_strData.clear();
+   m_bHasData = false;
+
+   if (!bContinue)
+      m_bStopped = true;
+
+   return bContinue;
+}
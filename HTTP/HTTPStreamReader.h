@@ -0,0 +1,128 @@
+/*
+ * @file HTTPStreamReader.h
+ * @brief readers splitting a streamed response body into lines (NDJSON) or Server-Sent Events
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPSTREAMREADER_H_
+#define INCLUDE_HTTPSTREAMREADER_H_
+
+#include <atomic>
+#include <cstddef>         // std::size_t
+#include <cstring>         // memcmp, strlen
+#include <functional>
+#include <string>
+
+/* Non-owning view of a line or of a field of an event : it points into the chunk received
+ * by libcurl or into a buffer of the reader, it is only valid during the callback. */
+struct CHTTPTextView
+{
+   CHTTPTextView() : pszData(""), usLength(0) {}
+   CHTTPTextView(const char* pData, const size_t usDataLength) : pszData(pData), usLength(usDataLength) {}
+   inline std::string ToString() const { return std::string(pszData, usLength); }
+   inline const bool Equals(const char* psz) const
+   {
+      return std::strlen(psz) == usLength && std::memcmp(pszData, psz, usLength) == 0;
+   }
+
+   const char* pszData; // not null-terminated
+   size_t usLength;
+};
+
+/* Splits a body delivered in chunks into lines as they arrive (e.g. NDJSON exports) : lines
+ * are terminated by "\n", "\r\n" or "\r" and delivered without their terminator. The line
+ * breaks are found with memchr, which is vectorised by the C library. A line contained in
+ * a chunk is delivered from the chunk, a line split by a chunk boundary is assembled in a
+ * buffer, which is reused. */
+class CHTTPLineReader
+{
+public:
+   // return false to stop the reading (the request is aborted)
+   typedef std::function<bool(const CHTTPTextView&)> LineFnCallback;
+
+   /* usMaxLineLength : lines longer than this stop the reading (0 : no limit) */
+   explicit CHTTPLineReader(const LineFnCallback& fnLine, const size_t usMaxLineLength = 0);
+   virtual ~CHTTPLineReader();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPLineReader(const CHTTPLineReader& Copy) = delete;
+   CHTTPLineReader& operator=(const CHTTPLineReader& Copy) = delete;
+
+   void Reset();
+   const bool Parse(const char* pData, const size_t usSize);
+   const bool Finish();
+
+   inline const bool IsStopped() const { return m_bStopped; }
+   inline const bool IsLineTooLong() const { return m_bLineTooLong; }
+   inline const size_t GetLinesCount() const { return m_usLines; }
+
+protected:
+   const bool DeliverLine(const char* pData, const size_t usLength);
+
+   LineFnCallback   m_fnLine;
+   size_t           m_usMaxLineLength;
+   std::string      m_strPending;      // beginning of a line split by a chunk boundary
+   bool             m_bSkipLF;         // the previous chunk ended with '\r'
+   bool             m_bStopped;
+   bool             m_bLineTooLong;
+   size_t           m_usLines;
+};
+
+/* Parses a Server-Sent Events stream (text/event-stream) as it arrives, see
+ * CHTTPClient::Subscribe. Each dispatched event is delivered as views into the reader's
+ * buffers, which are reused from an event to the next. The last event id and the
+ * reconnection delay sent by the server are kept across connections. */
+class CHTTPEventReader
+{
+public:
+   struct ServerEvent
+   {
+      CHTTPTextView Type;   // "message" if the event has no type
+      CHTTPTextView Data;   // data lines joined with '\n'
+      CHTTPTextView Id;     // last event id
+   };
+
+   // return false to stop listening (the request is aborted)
+   typedef std::function<bool(const ServerEvent&)> EventFnCallback;
+
+   /* usMaxLineLength : lines longer than this stop the reading (0 : no limit) */
+   explicit CHTTPEventReader(const EventFnCallback& fnEvent, const size_t usMaxLineLength = 0);
+   virtual ~CHTTPEventReader();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPEventReader(const CHTTPEventReader& Copy) = delete;
+   CHTTPEventReader& operator=(const CHTTPEventReader& Copy) = delete;
+
+   // a new connection starts : the event being received is discarded
+   void Reset();
+   const bool Parse(const char* pData, const size_t usSize);
+
+   /* stops listening, can be called from any thread : a connection without traffic notices
+    * it when it receives data (e.g. a keep-alive comment) */
+   inline void Stop() { m_bStopped = true; }
+   inline const bool IsStopped() const { return m_bStopped || m_LineReader.IsStopped(); }
+
+   inline const std::string& GetLastEventId() const { return m_strLastEventId; }
+   inline void SetLastEventId(const std::string& strId) { m_strLastEventId = strId; }
+   inline const long GetRetryDelay() const { return m_lRetryMs; }
+   inline void SetRetryDelay(const long lRetryMs) { m_lRetryMs = lRetryMs; }
+   inline const size_t GetEventsCount() const { return m_usEvents; }
+
+protected:
+   const bool OnLine(const CHTTPTextView& Line);
+   const bool Dispatch();
+
+   EventFnCallback     m_fnEvent;
+   CHTTPLineReader     m_LineReader;
+   std::string         m_strType;
+   std::string         m_strData;
+   bool                m_bHasData;
+   bool                m_bFirstLine;
+   std::string         m_strLastEventId;
+   long                m_lRetryMs;
+   std::atomic<bool>   m_bStopped;
+   size_t              m_usEvents;
+};
+
+#endif
@@ -0,0 +1,484 @@
+/**
+* @file HTTPTlsSessionCache.cpp
+* @brief implementation of the persistent TLS session cache
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPTlsSessionCache.h"
+
+#include <atomic>
+#include <cstdio>          // FILE, fopen, fprintf, rename, remove
+#include <cstring>         // strncmp
+#include <fstream>
+#include <sstream>
+
+#ifdef LINUX
+#include <fcntl.h>         // open
+#include <unistd.h>        // close
+#endif
+
+#ifdef HTTPCLIENT_OPENSSL
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+
+namespace
+{
+const char* const SESSION_FILE_HEADER = "# HTTPClient TLS sessions : host:port|certificate|verify expiry session";
+
+#ifdef HTTPCLIENT_OPENSSL
+typedef int (*NewSessionFn)(SSL*, SSL_SESSION*);
+
+// libcurl's own "new session" callback, called after ours (it feeds libcurl's cache)
+std::atomic<NewSessionFn> s_fnCurlNewSession(nullptr);
+
+// index of the cache in the ex data of the SSL_CTX created by libcurl for a connection
+int GetCacheIndex()
+{
+   static const int s_iIndex = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+   return s_iIndex;
+}
+
+// index of the key of the connection's sessions without the server name (a std::string
+// freed with the SSL_CTX), see SslCtxCallback
+int GetKeyIndex()
+{
+   static const int s_iIndex = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr,
+      [](void*, void* pKey, CRYPTO_EX_DATA*, int, long, void*) { delete static_cast<std::string*>(pKey); });
+   return s_iIndex;
+}
+#endif
+
+std::string EncodeHex(const std::string& strData)
+{
+   static const char HEX_DIGITS[] = "0123456789abcdef";
+
+   std::string strHex;
+   strHex.reserve(strData.size() * 2);
+   for (const char c : strData)
+   {
+      strHex += HEX_DIGITS[(static_cast<unsigned char>(c) >> 4) & 0x0F];
+      strHex += HEX_DIGITS[static_cast<unsigned char>(c) & 0x0F];
+   }
+   return strHex;
+}
+
+const bool DecodeHex(const std::string& strHex, std::string& strData)
+{
+   auto DigitValue = [](const char c) -> int
+   {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      return -1;
+   };
+
+   if (strHex.empty() || strHex.size() % 2 != 0)
+      return false;
+
+   strData.clear();
+   strData.reserve(strHex.size() / 2);
+   for (size_t i = 0; i < strHex.size(); i += 2)
+   {
+      const int iHigh = DigitValue(strHex[i]);
+      const int iLow = DigitValue(strHex[i + 1]);
+      if (iHigh < 0 || iLow < 0)
+         return false;
+      strData += static_cast<char>((iHigh << 4) | iLow);
+   }
+   return true;
+}
+}
+
+/**
+ * @brief constructor of the cache
+ *
+ * @param [in] usMaxEntries maximum number of hosts whose session is kept
+ */
+CHTTPTlsSessionCache::CHTTPTlsSessionCache(const size_t usMaxEntries /* = 1000 */) :
+   m_usMaxEntries(usMaxEntries)
+{
+}
+
+/**
+ * @brief destructor of the cache, the sessions must be exported before if they are kept
+ */
+CHTTPTlsSessionCache::~CHTTPTlsSessionCache()
+{
+}
+
+/**
+ * @brief returns true if the sessions can be recorded : the library is built with OpenSSL
+ * and libcurl uses it
+ */
+const bool CHTTPTlsSessionCache::IsSupported()
+{
+#ifdef HTTPCLIENT_OPENSSL
+   const curl_version_info_data* pVersion = curl_version_info(CURLVERSION_NOW);
+   return pVersion != nullptr && pVersion->ssl_version != nullptr
+       && std::strncmp(pVersion->ssl_version, "OpenSSL/", 8) == 0;
+#else
+   return false;
+#endif
+}
+
+/**
+ * @brief hooks the cache to the TLS connections established by a handle
+ *
+ * @param [in] pCurl handle, the hook is removed by curl_easy_reset
+ *
+ * @retval CURLE_OK             The handle records and resumes the cache's sessions.
+ * @retval CURLE_NOT_BUILT_IN   The TLS backend isn't supported, see IsSupported().
+ */
+const CURLcode CHTTPTlsSessionCache::Attach(CURL* pCurl)
+{
+#ifdef HTTPCLIENT_OPENSSL
+   if (IsSupported())
+   {
+      CURLcode res = curl_easy_setopt(pCurl, CURLOPT_SSL_CTX_FUNCTION, &CHTTPTlsSessionCache::SslCtxCallback);
+      if (res == CURLE_OK)
+         res = curl_easy_setopt(pCurl, CURLOPT_SSL_CTX_DATA, this);
+      return res;
+   }
+#else
+   (void)pCurl;
+#endif
+   return CURLE_NOT_BUILT_IN;
+}
+
+/**
+ * @brief removes the hook of a cache from a handle
+ */
+void CHTTPTlsSessionCache::Detach(CURL* pCurl)
+{
+   curl_easy_setopt(pCurl, CURLOPT_SSL_CTX_FUNCTION, nullptr);
+   curl_easy_setopt(pCurl, CURLOPT_SSL_CTX_DATA, nullptr);
+}
+
+/**
+ * @brief writes the sessions that haven't expired yet to a file, which is replaced
+ * atomically and created readable by its owner only
+ *
+ * @param [in] strFilePath path of the file
+ *
+ * @retval true   The sessions were written.
+ * @retval false  The file couldn't be written.
+ */
+const bool CHTTPTlsSessionCache::Export(const std::string& strFilePath) const
+{
+   const std::string strTmpPath = strFilePath + ".tmp";
+
+#ifdef LINUX
+   const int iFd = open(strTmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+   FILE* pFile = (iFd >= 0) ? fdopen(iFd, "w") : nullptr;
+   if (pFile == nullptr && iFd >= 0)
+      close(iFd);
+#else
+   FILE* pFile = fopen(strTmpPath.c_str(), "w");
+#endif
+   if (pFile == nullptr)
+      return false;
+
+   bool bWritten = fprintf(pFile, "%s\n", SESSION_FILE_HEADER) > 0;
+   {
+      std::lock_guard<std::mutex> Lock(m_mtxEntries);
+
+      const std::time_t tNow = std::time(nullptr);
+      for (auto it = m_mapEntries.cbegin(); bWritten && it != m_mapEntries.cend(); ++it)
+      {
+         if (it->second.tExpiry <= tNow)
+            continue;
+
+         bWritten = fprintf(pFile, "%s %lld %s\n", it->first.c_str(),
+                            static_cast<long long>(it->second.tExpiry),
+                            EncodeHex(it->second.strSession).c_str()) > 0;
+      }
+   }
+
+   if (fclose(pFile) != 0)
+      bWritten = false;
+
+#ifdef WINDOWS
+   // rename doesn't replace an existing file on Windows
+   if (bWritten)
+      remove(strFilePath.c_str());
+#endif
+   if (!bWritten || rename(strTmpPath.c_str(), strFilePath.c_str()) != 0)
+   {
+      remove(strTmpPath.c_str());
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * @brief loads the sessions of a file written by Export, the expired and invalid ones are
+ * skipped and a session of the cache expiring later than the file's one is kept
+ *
+ * @param [in] strFilePath path of the file
+ *
+ * @return number of sessions loaded
+ */
+const size_t CHTTPTlsSessionCache::Import(const std::string& strFilePath)
+{
+   std::ifstream File(strFilePath);
+   if (!File)
+      return 0;
+
+   const std::time_t tNow = std::time(nullptr);
+   size_t usImported = 0;
+   std::string strLine;
+
+   while (std::getline(File, strLine))
+   {
+      if (strLine.empty() || strLine[0] == '#')
+         continue;
+
+      std::istringstream Fields(strLine);
+      std::string strKey;
+      long long llExpiry = 0;
+      std::string strHex;
+      std::string strSession;
+
+      if (!(Fields >> strKey >> llExpiry >> strHex) || llExpiry <= tNow
+          || !DecodeHex(strHex, strSession))
+         continue;
+
+#ifdef HTTPCLIENT_OPENSSL
+      const unsigned char* pDer = reinterpret_cast<const unsigned char*>(strSession.data());
+      SSL_SESSION* pSession = d2i_SSL_SESSION(nullptr, &pDer, static_cast<long>(strSession.size()));
+      if (pSession == nullptr)
+         continue;
+      SSL_SESSION_free(pSession);
+#endif
+
+      std::lock_guard<std::mutex> Lock(m_mtxEntries);
+
+      auto it = m_mapEntries.find(strKey);
+      if (it != m_mapEntries.end() && it->second.tExpiry >= static_cast<std::time_t>(llExpiry))
+         continue;
+      if (it == m_mapEntries.end() && m_mapEntries.size() >= m_usMaxEntries)
+         continue;
+
+      Entry& CacheEntry = m_mapEntries[strKey];
+      CacheEntry.strSession = std::move(strSession);
+      CacheEntry.tExpiry = static_cast<std::time_t>(llExpiry);
+
+      ++m_Stats.usImported;
+      ++usImported;
+   }
+
+   return usImported;
+}
+
+/**
+ * @brief forgets all the sessions, the counters are kept
+ */
+void CHTTPTlsSessionCache::Clear()
+{
+   std::lock_guard<std::mutex> Lock(m_mtxEntries);
+   m_mapEntries.clear();
+}
+
+/**
+ * @brief returns the counters of the cache
+ */
+const CHTTPTlsSessionCache::TlsStats CHTTPTlsSessionCache::GetStats() const
+{
+   std::lock_guard<std::mutex> Lock(m_mtxEntries);
+
+   TlsStats Stats = m_Stats;
+   Stats.usEntries = m_mapEntries.size();
+   return Stats;
+}
+
+void CHTTPTlsSessionCache::StoreSession(const std::string& strKey, const std::string& strSession,
+                                        const std::time_t tExpiry)
+{
+   std::lock_guard<std::mutex> Lock(m_mtxEntries);
+
+   if (m_usMaxEntries == 0)
+      return;
+
+   if (m_mapEntries.size() >= m_usMaxEntries && m_mapEntries.find(strKey) == m_mapEntries.end())
+   {
+      auto itOldest = m_mapEntries.begin();
+      for (auto it = m_mapEntries.begin(); it != m_mapEntries.end(); ++it)
+      {
+         if (it->second.tExpiry < itOldest->second.tExpiry)
+            itOldest = it;
+      }
+      m_mapEntries.erase(itOldest);
+   }
+
+   Entry& CacheEntry = m_mapEntries[strKey];
+   CacheEntry.strSession = strSession;
+   CacheEntry.tExpiry = tExpiry;
+
+   ++m_Stats.usStored;
+}
+
+const bool CHTTPTlsSessionCache::FindSession(const std::string& strKey, std::string& strSession)
+{
+   std::lock_guard<std::mutex> Lock(m_mtxEntries);
+
+   auto it = m_mapEntries.find(strKey);
+   if (it == m_mapEntries.end())
+      return false;
+
+   if (it->second.tExpiry <= std::time(nullptr))
+   {
+      m_mapEntries.erase(it);
+      return false;
+   }
+
+   strSession = it->second.strSession;
+   return true;
+}
+
+void CHTTPTlsSessionCache::CountHandshake(const bool bResumed)
+{
+   std::lock_guard<std::mutex> Lock(m_mtxEntries);
+
+   if (bResumed)
+      ++m_Stats.usResumedHandshakes;
+   else
+      ++m_Stats.usFullHandshakes;
+}
+
+#ifdef HTTPCLIENT_OPENSSL
+namespace
+{
+// key of a connection's sessions : the server name followed by the key of its SSL_CTX
+const bool GetSessionKey(SSL* pSsl, std::string& strKey)
+{
+   const char* pszHost = SSL_get_servername(pSsl, TLSEXT_NAMETYPE_host_name);
+   const std::string* pContextKey = static_cast<const std::string*>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(pSsl), GetKeyIndex()));
+   if (pszHost == nullptr || pContextKey == nullptr)
+      return false;
+
+   strKey = pszHost + *pContextKey;
+   return true;
+}
+}
+
+/**
+ * @brief called by libcurl on the SSL_CTX of each new TLS connection, once configured and
+ * before the handshake : installs the callbacks recording and offering the sessions, and
+ * records the configuration the sessions will be keyed with (":port|certificate|verify")
+ */
+CURLcode CHTTPTlsSessionCache::SslCtxCallback(CURL* pCurl, void* pSslCtx, void* pUserData)
+{
+   SSL_CTX* pCtx = static_cast<SSL_CTX*>(pSslCtx);
+
+   // the server's port, from the URL being requested (redirections included) : without
+   // it, the sessions of the connection aren't cached
+   std::string* pContextKey = nullptr;
+   char* pszUrl = nullptr;
+   char* pszPort = nullptr;
+   CURLU* pUrl = curl_url();
+   curl_easy_getinfo(pCurl, CURLINFO_EFFECTIVE_URL, &pszUrl);
+   if (pUrl != nullptr && pszUrl != nullptr && curl_url_set(pUrl, CURLUPART_URL, pszUrl, 0) == CURLUE_OK
+       && curl_url_get(pUrl, CURLUPART_PORT, &pszPort, CURLU_DEFAULT_PORT) == CURLUE_OK)
+   {
+      pContextKey = new std::string(std::string(":") + pszPort);
+      curl_free(pszPort);
+
+      // the client certificate set by libcurl (its SHA-256), and the verification of the server
+      unsigned char szDigest[EVP_MAX_MD_SIZE];
+      unsigned int uDigestLength = 0;
+      X509* pCertificate = SSL_CTX_get0_certificate(pCtx);
+      *pContextKey += '|';
+      *pContextKey += (pCertificate != nullptr && X509_digest(pCertificate, EVP_sha256(), szDigest, &uDigestLength) == 1)
+                      ? EncodeHex(std::string(reinterpret_cast<char*>(szDigest), uDigestLength)) : "-";
+      *pContextKey += (SSL_CTX_get_verify_mode(pCtx) & SSL_VERIFY_PEER) ? "|verify" : "|noverify";
+   }
+   curl_url_cleanup(pUrl);
+
+   delete static_cast<std::string*>(SSL_CTX_get_ex_data(pCtx, GetKeyIndex()));
+   SSL_CTX_set_ex_data(pCtx, GetKeyIndex(), pContextKey);
+
+   // libcurl installs its callback when its session cache is enabled : it is chained
+   NewSessionFn fnCurrent = SSL_CTX_sess_get_new_cb(pCtx);
+   if (fnCurrent != nullptr && fnCurrent != &CHTTPTlsSessionCache::NewSessionCallback)
+      s_fnCurlNewSession.store(fnCurrent);
+
+   SSL_CTX_set_ex_data(pCtx, GetCacheIndex(), pUserData);
+
+   // the callback is only called by OpenSSL with the client cache mode
+   SSL_CTX_set_session_cache_mode(pCtx, SSL_CTX_get_session_cache_mode(pCtx)
+                                        | SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL);
+   SSL_CTX_sess_set_new_cb(pCtx, &CHTTPTlsSessionCache::NewSessionCallback);
+   SSL_CTX_set_info_callback(pCtx, &CHTTPTlsSessionCache::InfoCallback);
+
+   return CURLE_OK;
+}
+
+/**
+ * @brief called by OpenSSL when a server hands a session over (after the handshake in
+ * TLS 1.2, with each ticket in TLS 1.3)
+ */
+int CHTTPTlsSessionCache::NewSessionCallback(SSL* pSsl, SSL_SESSION* pSession)
+{
+   CHTTPTlsSessionCache* pCache = static_cast<CHTTPTlsSessionCache*>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(pSsl), GetCacheIndex()));
+   std::string strKey;
+
+   if (pCache != nullptr && GetSessionKey(pSsl, strKey) && SSL_SESSION_is_resumable(pSession))
+   {
+      const int iLength = i2d_SSL_SESSION(pSession, nullptr);
+      if (iLength > 0)
+      {
+         std::string strSession(static_cast<size_t>(iLength), '\0');
+         unsigned char* pDer = reinterpret_cast<unsigned char*>(&strSession[0]);
+         i2d_SSL_SESSION(pSession, &pDer);
+
+         const std::time_t tExpiry = static_cast<std::time_t>(SSL_SESSION_get_time(pSession)
+                                                            + SSL_SESSION_get_timeout(pSession));
+         pCache->StoreSession(strKey, strSession, tExpiry);
+      }
+   }
+
+   // the session is only serialized here : its ownership is libcurl's business
+   NewSessionFn fnCurlNewSession = s_fnCurlNewSession.load();
+   return (fnCurlNewSession != nullptr) ? fnCurlNewSession(pSsl, pSession) : 0;
+}
+
+/**
+ * @brief called by OpenSSL during the handshakes : offers the cached session when the
+ * handshake starts (unless libcurl already resumes one of its own) and counts the
+ * resumed handshakes when it is done
+ */
+void CHTTPTlsSessionCache::InfoCallback(const SSL* pSsl, int iWhere, int /*iRet*/)
+{
+   SSL* pConnection = const_cast<SSL*>(pSsl);
+   CHTTPTlsSessionCache* pCache = static_cast<CHTTPTlsSessionCache*>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(pConnection), GetCacheIndex()));
+   if (pCache == nullptr)
+      return;
+
+   if (iWhere & SSL_CB_HANDSHAKE_START)
+   {
+      std::string strKey;
+      std::string strSession;
+
+      if (SSL_get_session(pConnection) == nullptr && GetSessionKey(pConnection, strKey)
+          && pCache->FindSession(strKey, strSession))
+      {
+         const unsigned char* pDer = reinterpret_cast<const unsigned char*>(strSession.data());
+         SSL_SESSION* pSession = d2i_SSL_SESSION(nullptr, &pDer, static_cast<long>(strSession.size()));
+         if (pSession != nullptr)
+         {
+            // the ClientHello isn't built yet : the session is offered to the server
+            SSL_set_session(pConnection, pSession);
+            SSL_SESSION_free(pSession);
+         }
+      }
+   }
+   else if (iWhere & SSL_CB_HANDSHAKE_DONE)
+      pCache->CountHandshake(SSL_session_reused(pConnection) == 1);
+}
+#endif
@@ -0,0 +1,94 @@
+/*
+ * @file HTTPTlsSessionCache.h
+ * @brief TLS sessions kept across process restarts, to resume the handshakes
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPTLSSESSIONCACHE_H_
+#define INCLUDE_HTTPTLSSESSIONCACHE_H_
+
+#include <cstddef>         // std::size_t
+#include <curl/curl.h>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/* Records the TLS sessions (session tickets) negotiated by the sessions attached to it
+ * (see CHTTPClient::SetTlsSessionCache) and offers them back to the servers on the next
+ * connections, so the handshakes are abbreviated (TLS 1.2) or resumed with a PSK
+ * (TLS 1.3). libcurl already does this within a handle (or a CHTTPConnectionPool), this
+ * cache makes the sessions survive the process : export them to a file before exiting and
+ * import them at startup, so the first connections after a restart aren't full handshakes.
+ *
+ * As in libcurl's own cache, a session is only offered to the connections configured like
+ * the one that negotiated it : the sessions are keyed by the server name sent in the
+ * handshake (SNI) and the port, the client certificate and whether the server's
+ * certificate is verified. The hosts reached through their IP address aren't cached. The
+ * exported file holds the sessions' secrets : it is created readable by its owner only
+ * and must be protected like a private key.
+ *
+ * libcurl 7.88 has no API to export its sessions : the cache hooks OpenSSL through
+ * CURLOPT_SSL_CTX_FUNCTION. It is available when the library is built with OpenSSL
+ * (HTTPCLIENT_OPENSSL) and libcurl uses it as TLS backend, see IsSupported(). Otherwise
+ * attaching the cache has no effect. The class is thread-safe. */
+class CHTTPTlsSessionCache
+{
+public:
+   struct TlsStats
+   {
+      TlsStats() : usFullHandshakes(0), usResumedHandshakes(0), usStored(0), usImported(0),
+                   usEntries(0) {}
+      size_t usFullHandshakes;      // handshakes of the attached sessions that weren't resumed
+      size_t usResumedHandshakes;   // handshakes resumed (by this cache or by libcurl's one)
+      size_t usStored;              // sessions received from the servers
+      size_t usImported;            // sessions loaded from files
+      size_t usEntries;
+   };
+
+   // usMaxEntries : maximum number of hosts, the sessions expiring first are evicted beyond
+   explicit CHTTPTlsSessionCache(const size_t usMaxEntries = 1000);
+   virtual ~CHTTPTlsSessionCache();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPTlsSessionCache(const CHTTPTlsSessionCache& Copy) = delete;
+   CHTTPTlsSessionCache& operator=(const CHTTPTlsSessionCache& Copy) = delete;
+
+   static const bool IsSupported();
+
+   const CURLcode Attach(CURL* pCurl);
+   static void Detach(CURL* pCurl);
+
+   const bool Export(const std::string& strFilePath) const;
+   const size_t Import(const std::string& strFilePath);
+   void Clear();
+
+   const TlsStats GetStats() const;
+
+protected:
+   struct Entry
+   {
+      Entry() : tExpiry(0) {}
+      std::string strSession;   // DER encoded session
+      std::time_t tExpiry;
+   };
+
+   void StoreSession(const std::string& strKey, const std::string& strSession, const std::time_t tExpiry);
+   const bool FindSession(const std::string& strKey, std::string& strSession);
+   void CountHandshake(const bool bResumed);
+
+#ifdef HTTPCLIENT_OPENSSL
+   static CURLcode SslCtxCallback(CURL* pCurl, void* pSslCtx, void* pUserData);
+   static int NewSessionCallback(struct ssl_st* pSsl, struct ssl_session_st* pSession);
+   static void InfoCallback(const struct ssl_st* pSsl, int iWhere, int iRet);
+#endif
+
+   std::unordered_map<std::string, Entry> m_mapEntries;   // "host:port|certificate|verify" -> session
+   size_t                                 m_usMaxEntries;
+   TlsStats                               m_Stats;
+
+   mutable std::mutex                     m_mtxEntries;
+};
+
+#endif
@@ -0,0 +1,617 @@
+/**
+* @file HTTPTransferEngine.cpp
+* @brief implementation of the curl multi transfer engine
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPTransferEngine.h"
+
+/**
+ * @brief constructor of the transfer engine
+ *
+ * @param Logger - a callabck to a logger function void(const std::string&)
+ *
+ */
+CHTTPTransferEngine::CHTTPTransferEngine(CHTTPClient::LogFnCallback Logger) :
+   m_pMulti(nullptr),
+   m_bExternalLoop(false),
+   m_eSettingsFlags(CHTTPClient::ALL_FLAGS),
+   m_oLog(Logger),
+   m_curlHandle(CurlHandle::instance())
+{
+
+}
+
+/**
+ * @brief destructor of the transfer engine
+ *
+ */
+CHTTPTransferEngine::~CHTTPTransferEngine()
+{
+   if (m_pMulti != nullptr)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_WARNING_ENGINE_NOT_CLEANED);
+
+      CleanupEngine();
+   }
+}
+
+/**
+ * @brief creates the curl multi handle driving the requests
+ *
+ * @param [in] eSettingsFlags settings flags of the sessions created by the engine
+ *
+ * @retval true   Successfully initialized the engine.
+ * @retval false  The engine is already initialized or the multi handle couldn't be created.
+ */
+const bool CHTTPTransferEngine::InitEngine(const CHTTPClient::SettingsFlag& eSettingsFlags
+                                           /* = CHTTPClient::ALL_FLAGS */)
+{
+   if (m_pMulti)
+   {
+      if (eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_ERROR_MULTI_ALREADY_INIT_MSG);
+
+      return false;
+   }
+   m_pMulti = curl_multi_init();
+   m_eSettingsFlags = eSettingsFlags;
+
+   return (m_pMulti != nullptr);
+}
+
+/**
+ * @brief aborts the in-flight requests (their completion callbacks are not invoked),
+ * releases the pooled sessions and the multi handle
+ *
+ * @retval true   Successfully cleaned the engine.
+ * @retval false  The engine is not initialized.
+ */
+const bool CHTTPTransferEngine::CleanupEngine()
+{
+   if (!m_pMulti)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_ERROR_MULTI_NOT_INIT_MSG);
+
+      return false;
+   }
+
+   for (auto& itTransfer : m_mapTransfers)
+   {
+      curl_multi_remove_handle(m_pMulti, itTransfer.first);
+      itTransfer.second->pClient->FinishTransfer();
+      itTransfer.second->pClient->CleanupSession();
+   }
+   m_mapTransfers.clear();
+
+   for (auto& pClient : m_vecIdleClients)
+      pClient->CleanupSession();
+   m_vecIdleClients.clear();
+
+   curl_multi_cleanup(m_pMulti);
+   m_pMulti = nullptr;
+
+   if (m_bExternalLoop)
+   {
+      m_fnTimer(-1);
+      m_bExternalLoop = false;
+   }
+
+   return true;
+}
+
+/**
+ * @brief starts an asynchronous REST request
+ *
+ * The request is only set up here, it progresses when the engine is run and
+ * fnCompletion is called from Run() (or OnSocketEvent()/OnTimeout() when an external
+ * event loop drives the engine) once it is done.
+ *
+ * @param [in] eMethod HTTP method of the request
+ * @param [in] strUrl url to request encoded in UTF-8 format.
+ * @param [in] Headers headers to send
+ * @param [in] strBody data to send on POST, PUT and PATCH requests (ignored otherwise)
+ * @param [in] fnCompletion callback receiving the request's status and response
+ *
+ * @retval true   The request was added to the engine.
+ * @retval false  The request couldn't be set up, fnCompletion will not be called.
+ */
+const bool CHTTPTransferEngine::Submit(const RestMethod eMethod, const std::string& strUrl,
+                                       const CHTTPClient::HeadersMap& Headers, std::string strBody,
+                                       const CompletionFnCallback& fnCompletion)
+{
+   if (!m_pMulti)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_ERROR_MULTI_NOT_INIT_MSG);
+
+      return false;
+   }
+
+   std::unique_ptr<Transfer> pTransfer(new Transfer);
+   pTransfer->pClient = AcquireClient();
+   pTransfer->strBody = std::move(strBody);
+   pTransfer->fnCompletion = fnCompletion;
+
+   CHTTPClient& Client = *pTransfer->pClient;
+   if (!Client.m_pCurlSession || !Client.InitRestRequest(strUrl, Headers, pTransfer->Response))
+   {
+      ReleaseClient(std::move(pTransfer->pClient));
+      return false;
+   }
+
+   CURL* pCurl = Client.m_pCurlSession;
+   Client.SetRestMethod(static_cast<CHTTPClient::RestMethod>(eMethod), pTransfer->strBody, pTransfer->Payload);
+
+   if (Client.PrepareTransfer() != CURLE_OK)
+   {
+      Client.FinishTransfer();
+      ReleaseClient(std::move(pTransfer->pClient));
+      return false;
+   }
+
+   CURLMcode eCode = curl_multi_add_handle(m_pMulti, pCurl);
+   if (eCode != CURLM_OK)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(CHTTPClient::StringFormat(LOG_ERROR_MULTI_FAILURE_FORMAT, eCode, curl_multi_strerror(eCode)));
+
+      Client.FinishTransfer();
+      ReleaseClient(std::move(pTransfer->pClient));
+      return false;
+   }
+
+   m_mapTransfers.emplace(pCurl, std::move(pTransfer));
+
+   return true;
+}
+
+/**
+ * @brief performs a batch of independent REST requests and stores their outcome
+ * in the same order as the requests
+ *
+ * @param [in] vecRequests requests to perform
+ * @param [out] vecResults outcome of each request (same size and order as vecRequests)
+ * @param [in] usMaxConcurrency maximum number of requests in progress at the same time
+ * @param [in] usMaxPerHost maximum number of requests in progress to the same host
+ *
+ * @retval true   All the requests were performed (check each result's status).
+ * @retval false  The engine is not initialized or is driven by an external event loop.
+ */
+const bool CHTTPTransferEngine::PerformBatch(const std::vector<BatchRequest>& vecRequests,
+                                             std::vector<BatchResult>& vecResults,
+                                             const size_t usMaxConcurrency,
+                                             const size_t usMaxPerHost /* = 0 */)
+{
+   vecResults.clear();
+   vecResults.resize(vecRequests.size());
+
+   return PerformBatch(vecRequests,
+      [&vecResults](const size_t usIndex, const bool bSuccess, CHTTPClient::HttpResponse& Response)
+      {
+         vecResults[usIndex].bSuccess = bSuccess;
+         vecResults[usIndex].Response = std::move(Response);
+      },
+      usMaxConcurrency, usMaxPerHost);
+}
+
+/**
+ * @brief performs a batch of independent REST requests, their outcome is streamed
+ * to a callback as soon as each of them is done (in completion order)
+ *
+ * Requests are started in input order, while respecting the concurrency limits,
+ * and different hosts are served in a round-robin fashion. The method returns
+ * once all the requests are done.
+ *
+ * @param [in] vecRequests requests to perform
+ * @param [in] fnCompletion callback receiving the index of the request, its status and response
+ * @param [in] usMaxConcurrency maximum number of requests in progress at the same time
+ * @param [in] usMaxPerHost maximum number of requests in progress to the same host
+ *
+ * @retval true   All the requests were performed (check each request's status).
+ * @retval false  The engine is not initialized or is driven by an external event loop.
+ */
+const bool CHTTPTransferEngine::PerformBatch(const std::vector<BatchRequest>& vecRequests,
+                                             const BatchCompletionFnCallback& fnCompletion,
+                                             const size_t usMaxConcurrency,
+                                             const size_t usMaxPerHost /* = 0 */)
+{
+   if (!m_pMulti)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_ERROR_MULTI_NOT_INIT_MSG);
+
+      return false;
+   }
+   if (m_bExternalLoop)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_ERROR_EXTERNAL_LOOP_MSG);
+
+      return false;
+   }
+
+   // pending requests are queued per host, hosts having room for one more request
+   // are themselves queued (round-robin), so picking the next request is O(1)
+   struct HostQueue
+   {
+      HostQueue() : usInFlight(0), bReady(false) {}
+      std::deque<size_t> dqPending;
+      size_t             usInFlight;
+      bool               bReady;
+   };
+   std::vector<HostQueue> vecHosts;
+   std::vector<size_t> vecRequestHost(vecRequests.size());
+   std::unordered_map<std::string, size_t> mapHostIndex;
+   std::deque<size_t> dqReadyHosts;
+
+   for (size_t usIndex = 0; usIndex < vecRequests.size(); ++usIndex)
+   {
+      auto itHost = mapHostIndex.emplace(GetUrlHost(vecRequests[usIndex].strUrl), vecHosts.size());
+      if (itHost.second)
+         vecHosts.emplace_back();
+
+      const size_t usHost = itHost.first->second;
+      vecRequestHost[usIndex] = usHost;
+      vecHosts[usHost].dqPending.push_back(usIndex);
+      if (!vecHosts[usHost].bReady)
+      {
+         vecHosts[usHost].bReady = true;
+         dqReadyHosts.push_back(usHost);
+      }
+   }
+
+   const size_t usMaxInFlight = (usMaxConcurrency > 0) ? usMaxConcurrency : vecRequests.size();
+   const size_t usMaxHostInFlight = (usMaxPerHost > 0) ? usMaxPerHost : vecRequests.size();
+   size_t usInFlight = 0;
+   size_t usRemaining = vecRequests.size();
+
+   auto fnRequeueHost = [&](const size_t usHost)
+   {
+      HostQueue& Host = vecHosts[usHost];
+      if (!Host.bReady && !Host.dqPending.empty() && Host.usInFlight < usMaxHostInFlight)
+      {
+         Host.bReady = true;
+         dqReadyHosts.push_back(usHost);
+      }
+   };
+
+   auto fnDone = [&](const size_t usIndex, const bool bSuccess, CHTTPClient::HttpResponse& Response)
+   {
+      --usInFlight;
+      --usRemaining;
+      --vecHosts[vecRequestHost[usIndex]].usInFlight;
+      fnRequeueHost(vecRequestHost[usIndex]);
+
+      if (fnCompletion)
+         fnCompletion(usIndex, bSuccess, Response);
+   };
+
+   auto fnLaunch = [&]()
+   {
+      while (usInFlight < usMaxInFlight && !dqReadyHosts.empty())
+      {
+         const size_t usHost = dqReadyHosts.front();
+         dqReadyHosts.pop_front();
+
+         HostQueue& Host = vecHosts[usHost];
+         Host.bReady = false;
+
+         const size_t usIndex = Host.dqPending.front();
+         Host.dqPending.pop_front();
+         ++Host.usInFlight;
+         ++usInFlight;
+         fnRequeueHost(usHost);
+
+         const BatchRequest& Request = vecRequests[usIndex];
+         const bool bSubmitted = Submit(Request.eMethod, Request.strUrl, Request.Headers, Request.strBody,
+            [&fnDone, usIndex](const bool bSuccess, CHTTPClient::HttpResponse& Response)
+            {
+               fnDone(usIndex, bSuccess, Response);
+            });
+
+         if (!bSubmitted)
+         {
+            CHTTPClient::HttpResponse Response;
+            Response.iCode = -1;
+            fnDone(usIndex, false, Response);
+         }
+      }
+   };
+
+   fnLaunch();
+   while (usRemaining > 0)
+   {
+      Run(1000);
+      fnLaunch();
+   }
+
+   return true;
+}
+
+/**
+ * @brief performs one iteration of the event loop : transfers the available data,
+ * waits at most iTimeoutMs for activity and invokes the callbacks of the completed requests.
+ *
+ * Must not be called from a completion callback.
+ *
+ * @param [in] iTimeoutMs maximum time to wait for activity, in milliseconds
+ *
+ * @return number of requests still in progress, -1 if the engine is not initialized
+ */
+const int CHTTPTransferEngine::Run(const int iTimeoutMs)
+{
+   if (!m_pMulti)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_ERROR_MULTI_NOT_INIT_MSG);
+
+      return -1;
+   }
+   if (m_bExternalLoop)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_ERROR_EXTERNAL_LOOP_MSG);
+
+      return -1;
+   }
+
+   int iRunning = 0;
+   curl_multi_perform(m_pMulti, &iRunning);
+   ProcessCompletions();
+
+   if (!m_mapTransfers.empty())
+   {
+      CURLMcode eCode = curl_multi_poll(m_pMulti, nullptr, 0, iTimeoutMs, nullptr);
+      if (eCode != CURLM_OK && (m_eSettingsFlags & CHTTPClient::ENABLE_LOG))
+         m_oLog(CHTTPClient::StringFormat(LOG_ERROR_MULTI_FAILURE_FORMAT, eCode, curl_multi_strerror(eCode)));
+
+      curl_multi_perform(m_pMulti, &iRunning);
+      ProcessCompletions();
+   }
+
+   return static_cast<int>(m_mapTransfers.size());
+}
+
+/**
+ * @brief runs the event loop until all the submitted requests (including the ones
+ * submitted by completion callbacks) are done
+ */
+void CHTTPTransferEngine::RunAll()
+{
+   while (Run(1000) > 0)
+      ;
+}
+
+/**
+ * @brief wakes up a Run() call waiting for activity, can be called from any thread
+ */
+void CHTTPTransferEngine::Wakeup()
+{
+   if (m_pMulti)
+      curl_multi_wakeup(m_pMulti);
+}
+
+/**
+ * @brief hands the engine over to an external event loop
+ *
+ * fnSocket is called whenever a socket must be watched (SOCKET_IN and/or SOCKET_OUT)
+ * or must not be watched anymore (SOCKET_REMOVE). fnTimer is called whenever the single
+ * timeout of the engine must be (re)armed (-1 to disarm it) : when it expires, the loop
+ * must call OnTimeout(). When a watched socket is ready, the loop must call OnSocketEvent().
+ * The callbacks must not call back the engine. Once set, Run() can't be used anymore.
+ *
+ * @param [in] fnSocket socket interest callback
+ * @param [in] fnTimer timer callback
+ *
+ * @retval true   The engine is now driven by the external loop.
+ * @retval false  The engine is not initialized or a request is in progress.
+ */
+const bool CHTTPTransferEngine::SetEventLoopCallbacks(const SocketFnCallback& fnSocket,
+                                                      const TimerFnCallback& fnTimer)
+{
+   if (!m_pMulti)
+   {
+      if (m_eSettingsFlags & CHTTPClient::ENABLE_LOG)
+         m_oLog(LOG_ERROR_MULTI_NOT_INIT_MSG);
+
+      return false;
+   }
+   if (!fnSocket || !fnTimer || !m_mapTransfers.empty())
+      return false;
+
+   m_fnSocket = fnSocket;
+   m_fnTimer = fnTimer;
+
+   curl_multi_setopt(m_pMulti, CURLMOPT_SOCKETFUNCTION, &CHTTPTransferEngine::SocketCallback);
+   curl_multi_setopt(m_pMulti, CURLMOPT_SOCKETDATA, this);
+   curl_multi_setopt(m_pMulti, CURLMOPT_TIMERFUNCTION, &CHTTPTransferEngine::TimerCallback);
+   curl_multi_setopt(m_pMulti, CURLMOPT_TIMERDATA, this);
+
+   m_bExternalLoop = true;
+
+   return true;
+}
+
+/**
+ * @brief associates a user pointer with a watched socket (e.g. a libuv poll handle),
+ * it will be passed back to the socket callback
+ *
+ * @retval true   The pointer was associated with the socket.
+ * @retval false  The socket is unknown to the engine.
+ */
+const bool CHTTPTransferEngine::AssignSocketData(curl_socket_t Socket, void* pData)
+{
+   return m_pMulti && curl_multi_assign(m_pMulti, Socket, pData) == CURLM_OK;
+}
+
+/**
+ * @brief to be called by the external loop when a watched socket is ready
+ *
+ * @param [in] Socket ready socket
+ * @param [in] iEvents SocketEvent flags (0 if unknown)
+ */
+void CHTTPTransferEngine::OnSocketEvent(curl_socket_t Socket, const int iEvents)
+{
+   if (!m_pMulti)
+      return;
+
+   int iRunning = 0;
+   CURLMcode eCode = curl_multi_socket_action(m_pMulti, Socket, iEvents, &iRunning);
+   if (eCode != CURLM_OK && (m_eSettingsFlags & CHTTPClient::ENABLE_LOG))
+      m_oLog(CHTTPClient::StringFormat(LOG_ERROR_MULTI_FAILURE_FORMAT, eCode, curl_multi_strerror(eCode)));
+
+   ProcessCompletions();
+}
+
+/**
+ * @brief to be called by the external loop when the timeout armed by the timer callback expires
+ */
+void CHTTPTransferEngine::OnTimeout()
+{
+   OnSocketEvent(CURL_SOCKET_TIMEOUT, 0);
+}
+
+/**
+ * @brief extracts the host (and port) part of a URL, used to apply per-host limits
+ *
+ * @param [in] strUrl URL with or without a scheme
+ *
+ * @return host[:port] (lower case)
+ */
+std::string CHTTPTransferEngine::GetUrlHost(const std::string& strUrl)
+{
+   size_t usStart = strUrl.find("://");
+   usStart = (usStart == std::string::npos) ? 0 : usStart + 3;
+
+   size_t usEnd = strUrl.find_first_of("/?#", usStart);
+   if (usEnd == std::string::npos)
+      usEnd = strUrl.size();
+
+   // skip user info
+   const size_t usAt = strUrl.rfind('@', usEnd);
+   if (usAt != std::string::npos && usAt >= usStart)
+      usStart = usAt + 1;
+
+   std::string strHost = strUrl.substr(usStart, usEnd - usStart);
+   std::transform(strHost.begin(), strHost.end(), strHost.begin(), ::tolower);
+
+   return strHost;
+}
+
+/**
+ * @brief returns an idle session from the pool or creates a new one
+ */
+std::unique_ptr<CHTTPClient> CHTTPTransferEngine::AcquireClient()
+{
+   if (!m_vecIdleClients.empty())
+   {
+      std::unique_ptr<CHTTPClient> pClient = std::move(m_vecIdleClients.back());
+      m_vecIdleClients.pop_back();
+      return pClient;
+   }
+
+   std::unique_ptr<CHTTPClient> pClient(new CHTTPClient(m_oLog));
+   pClient->InitSession(false, m_eSettingsFlags);
+
+   if (m_fnClientSetup)
+      m_fnClientSetup(*pClient);
+
+   return pClient;
+}
+
+/**
+ * @brief puts back a session in the pool of idle sessions
+ */
+void CHTTPTransferEngine::ReleaseClient(std::unique_ptr<CHTTPClient> pClient)
+{
+   if (pClient)
+      m_vecIdleClients.push_back(std::move(pClient));
+}
+
+/**
+ * @brief reads the messages of the multi handle and completes the finished requests
+ */
+void CHTTPTransferEngine::ProcessCompletions()
+{
+   CURLMsg* pMsg = nullptr;
+   int iMsgsLeft = 0;
+
+   while ((pMsg = curl_multi_info_read(m_pMulti, &iMsgsLeft)) != nullptr)
+   {
+      if (pMsg->msg != CURLMSG_DONE)
+         continue;
+
+      CURL* pCurl = pMsg->easy_handle;
+      const CURLcode eResult = pMsg->data.result;
+
+      curl_multi_remove_handle(m_pMulti, pCurl);
+
+      auto itTransfer = m_mapTransfers.find(pCurl);
+      if (itTransfer == m_mapTransfers.end())
+         continue;
+
+      std::unique_ptr<Transfer> pTransfer = std::move(itTransfer->second);
+      m_mapTransfers.erase(itTransfer);
+
+      pTransfer->pClient->FinishTransfer(eResult);
+      const bool bSuccess = pTransfer->pClient->PostRestRequest(eResult, pTransfer->Response);
+      ReleaseClient(std::move(pTransfer->pClient));
+
+      if (pTransfer->fnCompletion)
+         pTransfer->fnCompletion(bSuccess, pTransfer->Response);
+   }
+}
+
+// CURL MULTI SOCKET CALLBACKS
+
+/**
+* @brief socket callback for libcurl, forwards the socket interest to the external loop
+*
+* @param pCurl easy handle using the socket
+* @param Socket socket
+* @param iWhat CURL_POLL_* interest
+* @param pUserData pointer to the engine
+* @param pSocketData pointer assigned with AssignSocketData
+*
+* @return 0
+*/
+int CHTTPTransferEngine::SocketCallback(CURL* /*pCurl*/, curl_socket_t Socket, int iWhat,
+                                        void* pUserData, void* pSocketData)
+{
+   CHTTPTransferEngine* pEngine = reinterpret_cast<CHTTPTransferEngine*>(pUserData);
+
+   int iInterest = 0;
+   switch (iWhat)
+   {
+   case CURL_POLL_IN:    iInterest = SOCKET_IN; break;
+   case CURL_POLL_OUT:   iInterest = SOCKET_OUT; break;
+   case CURL_POLL_INOUT: iInterest = SOCKET_IN | SOCKET_OUT; break;
+   case CURL_POLL_REMOVE:
+   default:              iInterest = SOCKET_REMOVE; break;
+   }
+
+   pEngine->m_fnSocket(Socket, iInterest, pSocketData);
+
+   return 0;
+}
+
+/**
+* @brief timer callback for libcurl, forwards the timeout to the external loop
+*
+* @param pMulti multi handle
+* @param lTimeoutMs timeout in milliseconds, -1 to delete the timer
+* @param pUserData pointer to the engine
+*
+* @return 0
+*/
+int CHTTPTransferEngine::TimerCallback(CURLM* /*pMulti*/, long lTimeoutMs, void* pUserData)
+{
+   CHTTPTransferEngine* pEngine = reinterpret_cast<CHTTPTransferEngine*>(pUserData);
+
+   pEngine->m_fnTimer(lTimeoutMs);
+
+   return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * @file HTTPTransferEngine.h
+ * @brief curl multi based engine driving many REST requests concurrently
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPTRANSFERENGINE_H_
+#define INCLUDE_HTTPTRANSFERENGINE_H_
+
+#include <deque>
+#include <functional>
+#include <memory>    // std::unique_ptr
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "HTTPClient.h"
+
+/* Runs REST requests concurrently on a single curl multi handle.
+ *
+ * Every in-flight request uses its own CHTTPClient session, taken from a pool of
+ * idle sessions owned by the engine, so all the client settings (timeout, proxy,
+ * SSL...) apply as usual. The engine is not thread-safe : requests must be submitted
+ * and the engine must be run from the same thread. Completion callbacks are invoked
+ * from Run(), on the calling thread.
+ *
+ * Instead of Run(), the engine can be driven by an external event loop (epoll, libuv...) :
+ * after SetEventLoopCallbacks(), the engine reports the sockets to watch and the timeout
+ * to arm, and the loop calls OnSocketEvent()/OnTimeout() back. Completion callbacks are
+ * then invoked from these two methods. */
+class CHTTPTransferEngine
+{
+public:
+   // Public definitions
+   typedef std::function<void(const bool, CHTTPClient::HttpResponse&)> CompletionFnCallback;
+   typedef std::function<void(CHTTPClient&)>                           ClientSetupFnCallback;
+   // socket to (un)watch and SocketInterest flags, per-socket data set with AssignSocketData
+   typedef std::function<void(curl_socket_t, const int, void*)>        SocketFnCallback;
+   // timeout to (re)arm in milliseconds, -1 to disarm it
+   typedef std::function<void(const long)>                             TimerFnCallback;
+
+   enum SocketInterest
+   {
+      SOCKET_IN = 0x01,
+      SOCKET_OUT = 0x02,
+      SOCKET_REMOVE = 0x04
+   };
+
+   enum SocketEvent
+   {
+      EVENT_IN = CURL_CSELECT_IN,
+      EVENT_OUT = CURL_CSELECT_OUT,
+      EVENT_ERR = CURL_CSELECT_ERR
+   };
+
+   enum RestMethod
+   {
+      REST_HEAD = CHTTPClient::REST_HEAD,
+      REST_GET = CHTTPClient::REST_GET,
+      REST_DELETE = CHTTPClient::REST_DELETE,
+      REST_POST = CHTTPClient::REST_POST,
+      REST_PUT = CHTTPClient::REST_PUT,
+      REST_PATCH = CHTTPClient::REST_PATCH,
+      REST_OPTIONS = CHTTPClient::REST_OPTIONS
+   };
+
+   // description of a request of a batch
+   struct BatchRequest
+   {
+      BatchRequest() : eMethod(REST_GET) {}
+      BatchRequest(const RestMethod eRestMethod, const std::string& strRequestUrl,
+                   const CHTTPClient::HeadersMap& RequestHeaders = CHTTPClient::HeadersMap(),
+                   const std::string& strRequestBody = std::string()) :
+         eMethod(eRestMethod), strUrl(strRequestUrl), Headers(RequestHeaders), strBody(strRequestBody) {}
+      RestMethod              eMethod;
+      std::string             strUrl;
+      CHTTPClient::HeadersMap Headers;
+      std::string             strBody; // data to send on POST, PUT and PATCH requests
+   };
+
+   // outcome of a request of a batch
+   struct BatchResult
+   {
+      BatchResult() : bSuccess(false) {}
+      bool                      bSuccess;
+      CHTTPClient::HttpResponse Response;
+   };
+
+   // index of the request in the batch, status and response
+   typedef std::function<void(const size_t, const bool, CHTTPClient::HttpResponse&)> BatchCompletionFnCallback;
+
+   explicit CHTTPTransferEngine(CHTTPClient::LogFnCallback oLogger);
+   virtual ~CHTTPTransferEngine();
+
+   // copy constructor and assignment operator are disabled
+   CHTTPTransferEngine(const CHTTPTransferEngine& Copy) = delete;
+   CHTTPTransferEngine& operator=(const CHTTPTransferEngine& Copy) = delete;
+
+   // Engine
+   const bool InitEngine(const CHTTPClient::SettingsFlag& SettingsFlags = CHTTPClient::ALL_FLAGS);
+   const bool CleanupEngine();
+   const CURLM* GetMultiPointer() const { return m_pMulti; }
+
+   /* called once on every session created by the engine (e.g. to set a timeout,
+    * a proxy, SSL files...) */
+   inline void SetClientSetupFnCallback(const ClientSetupFnCallback& fnSetup) { m_fnClientSetup = fnSetup; }
+
+   // Asynchronous REST requests
+   const bool Submit(const RestMethod eMethod, const std::string& strUrl,
+                     const CHTTPClient::HeadersMap& Headers, std::string strBody,
+                     const CompletionFnCallback& fnCompletion);
+
+   // Batch requests (0 means no limit)
+   const bool PerformBatch(const std::vector<BatchRequest>& vecRequests,
+                           std::vector<BatchResult>& vecResults,
+                           const size_t usMaxConcurrency, const size_t usMaxPerHost = 0);
+   const bool PerformBatch(const std::vector<BatchRequest>& vecRequests,
+                           const BatchCompletionFnCallback& fnCompletion,
+                           const size_t usMaxConcurrency, const size_t usMaxPerHost = 0);
+
+   // Event loop
+   const int Run(const int iTimeoutMs);
+   void RunAll();
+   void Wakeup();
+
+   // External event loop
+   const bool SetEventLoopCallbacks(const SocketFnCallback& fnSocket, const TimerFnCallback& fnTimer);
+   const bool AssignSocketData(curl_socket_t Socket, void* pData);
+   void OnSocketEvent(curl_socket_t Socket, const int iEvents);
+   void OnTimeout();
+   inline const bool IsExternalLoop() const { return m_bExternalLoop; }
+
+   inline const size_t GetRunningCount() const { return m_mapTransfers.size(); }
+   inline const size_t GetIdleClientsCount() const { return m_vecIdleClients.size(); }
+
+protected:
+   struct Transfer
+   {
+      Transfer() : pClient(nullptr) {}
+      std::unique_ptr<CHTTPClient> pClient;
+      CHTTPClient::HttpResponse    Response;
+      std::string                  strBody;
+      CHTTPClient::UploadObject    Payload;
+      CompletionFnCallback         fnCompletion;
+   };
+
+   static std::string GetUrlHost(const std::string& strUrl);
+
+   std::unique_ptr<CHTTPClient> AcquireClient();
+   void ReleaseClient(std::unique_ptr<CHTTPClient> pClient);
+   void ProcessCompletions();
+
+   // curl multi socket interface callbacks
+   static int SocketCallback(CURL* pCurl, curl_socket_t Socket, int iWhat, void* pUserData, void* pSocketData);
+   static int TimerCallback(CURLM* pMulti, long lTimeoutMs, void* pUserData);
+
+   CURLM*                       m_pMulti;
+   bool                         m_bExternalLoop;
+   SocketFnCallback             m_fnSocket;
+   TimerFnCallback              m_fnTimer;
+   CHTTPClient::SettingsFlag    m_eSettingsFlags;
+   CHTTPClient::LogFnCallback   m_oLog;
+   ClientSetupFnCallback        m_fnClientSetup;
+
+   std::vector<std::unique_ptr<CHTTPClient>>               m_vecIdleClients;
+   std::unordered_map<CURL*, std::unique_ptr<Transfer>>    m_mapTransfers;
+
+private:
+   CurlHandle& m_curlHandle;
+};
+
+// Logs messages
+#define LOG_ERROR_MULTI_ALREADY_INIT_MSG        "[HTTPTransferEngine][Error] Multi handle is already initialized ! " \
+                                                "Use CleanupEngine() to clean the present one."
+#define LOG_ERROR_MULTI_NOT_INIT_MSG            "[HTTPTransferEngine][Error] Multi handle is not initialized ! " \
+                                                "Use InitEngine() before."
+#define LOG_WARNING_ENGINE_NOT_CLEANED          "[HTTPTransferEngine][Warning] Object was freed before calling " \
+                                                "CHTTPTransferEngine::CleanupEngine(). The engine was cleaned though."
+#define LOG_ERROR_EXTERNAL_LOOP_MSG             "[HTTPTransferEngine][Error] The engine is driven by an external event loop, " \
+                                                "use OnSocketEvent() and OnTimeout() instead of Run()."
+#define LOG_ERROR_MULTI_FAILURE_FORMAT          "[HTTPTransferEngine][Error] curl multi operation failed " \
+                                                "(Error = %d | %s)"
+
+#endif
@@ -0,0 +1,217 @@
+/**
+* @file HTTPUrlBuilder.cpp
+* @brief implementation of the URL and query string builder
+* @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+*/
+
+#include "HTTPUrlBuilder.h"
+
+#include <cstdio>          // snprintf
+#include <cstring>         // strlen, memcpy
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HTTPCLIENT_SSE2
+#endif
+
+namespace
+{
+// RFC 3986 unreserved characters : ALPHA / DIGIT / "-" / "." / "_" / "~"
+inline bool IsUnreserved(const unsigned char c)
+{
+   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+          c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+#ifdef HTTPCLIENT_SSE2
+// returns true if the 16 bytes are all unreserved characters
+inline bool AreUnreserved16(const char* pszData)
+{
+   const __m128i Chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pszData));
+
+   // signed comparisons : bytes >= 0x80 are negative and never in range
+   const __m128i Lower = _mm_and_si128(_mm_cmpgt_epi8(Chunk, _mm_set1_epi8('a' - 1)),
+                                       _mm_cmplt_epi8(Chunk, _mm_set1_epi8('z' + 1)));
+   const __m128i Upper = _mm_and_si128(_mm_cmpgt_epi8(Chunk, _mm_set1_epi8('A' - 1)),
+                                       _mm_cmplt_epi8(Chunk, _mm_set1_epi8('Z' + 1)));
+   const __m128i Digit = _mm_and_si128(_mm_cmpgt_epi8(Chunk, _mm_set1_epi8('0' - 1)),
+                                       _mm_cmplt_epi8(Chunk, _mm_set1_epi8('9' + 1)));
+   const __m128i Mark = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Chunk, _mm_set1_epi8('-')),
+                                                  _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('.'))),
+                                     _mm_or_si128(_mm_cmpeq_epi8(Chunk, _mm_set1_epi8('_')),
+                                                  _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('~'))));
+
+   const __m128i Safe = _mm_or_si128(_mm_or_si128(Lower, Upper), _mm_or_si128(Digit, Mark));
+
+   return _mm_movemask_epi8(Safe) == 0xFFFF;
+}
+#endif
+}
+
+/**
+ * @brief constructor of an empty URL builder
+ */
+CHTTPUrlBuilder::CHTTPUrlBuilder() :
+   m_bHasQuery(false)
+{
+}
+
+/**
+ * @brief constructor of a URL builder
+ *
+ * @param [in] strBaseUrl URL to which parameters will be added
+ */
+CHTTPUrlBuilder::CHTTPUrlBuilder(const std::string& strBaseUrl) :
+   m_bHasQuery(false)
+{
+   SetBase(strBaseUrl);
+}
+
+/**
+ * @brief starts a new URL, the previous parameters are discarded
+ *
+ * @param [in] strBaseUrl URL (which may already have a query string) to which parameters will be added
+ */
+CHTTPUrlBuilder& CHTTPUrlBuilder::SetBase(const std::string& strBaseUrl)
+{
+   return SetBase(strBaseUrl.data(), strBaseUrl.size());
+}
+
+/**
+ * @brief starts a new URL, the previous parameters are discarded
+ *
+ * @param [in] pszBaseUrl URL (which may already have a query string) to which parameters will be added
+ * @param [in] usLength length of the URL
+ */
+CHTTPUrlBuilder& CHTTPUrlBuilder::SetBase(const char* pszBaseUrl, const size_t usLength)
+{
+   m_strUrl.assign(pszBaseUrl, usLength);
+   m_bHasQuery = (std::memchr(pszBaseUrl, '?', usLength) != nullptr);
+
+   return *this;
+}
+
+/**
+ * @brief appends a query parameter
+ *
+ * @param [in] strKey name of the parameter
+ * @param [in] strValue value of the parameter
+ */
+CHTTPUrlBuilder& CHTTPUrlBuilder::AddParam(const std::string& strKey, const std::string& strValue)
+{
+   return AddParam(strKey.data(), strKey.size(), strValue.data(), strValue.size());
+}
+
+/**
+ * @brief appends a query parameter
+ *
+ * @param [in] pszKey name of the parameter
+ * @param [in] usKeyLength length of the name
+ * @param [in] pszValue value of the parameter
+ * @param [in] usValueLength length of the value
+ */
+CHTTPUrlBuilder& CHTTPUrlBuilder::AddParam(const char* pszKey, const size_t usKeyLength,
+                                           const char* pszValue, const size_t usValueLength)
+{
+   m_strUrl += (m_bHasQuery) ? '&' : '?';
+   m_bHasQuery = true;
+
+   AppendEncoded(m_strUrl, pszKey, usKeyLength);
+   m_strUrl += '=';
+   AppendEncoded(m_strUrl, pszValue, usValueLength);
+
+   return *this;
+}
+
+/**
+ * @brief appends a numeric query parameter
+ *
+ * @param [in] strKey name of the parameter
+ * @param [in] llValue value of the parameter
+ */
+CHTTPUrlBuilder& CHTTPUrlBuilder::AddParam(const std::string& strKey, const long long llValue)
+{
+   char szValue[24];
+   const int iLength = std::snprintf(szValue, sizeof(szValue), "%lld", llValue);
+
+   return AddParam(strKey.data(), strKey.size(), szValue, static_cast<size_t>(iLength));
+}
+
+/**
+ * @brief percent-encodes data (RFC 3986) at the end of a string, in a single pass
+ *
+ * The data is split in runs of unreserved characters, appended at once, and runs of
+ * escaped bytes. When SSE2 is available, each run of unreserved characters is scanned
+ * 16 bytes at a time, including the runs following an escaped byte.
+ *
+ * @param [in/out] strOutput string to which the encoded data is appended
+ * @param [in] pszData data to encode
+ * @param [in] usLength length of the data
+ */
+void CHTTPUrlBuilder::AppendEncoded(std::string& strOutput, const char* pszData, const size_t usLength)
+{
+   static const char s_szHex[] = "0123456789ABCDEF";
+
+   // mostly unreserved data : the escaped bytes grow the string only when needed
+   strOutput.reserve(strOutput.size() + usLength);
+
+   size_t i = 0;
+   while (i < usLength)
+   {
+      const size_t usRunStart = i;
+#ifdef HTTPCLIENT_SSE2
+      while (i + 16 <= usLength && AreUnreserved16(pszData + i))
+         i += 16;
+#endif
+      while (i < usLength && IsUnreserved(static_cast<unsigned char>(pszData[i])))
+         ++i;
+      strOutput.append(pszData + usRunStart, i - usRunStart);
+
+      char szEscaped[48];
+      size_t usEscaped = 0;
+      while (i < usLength && usEscaped + 3 <= sizeof(szEscaped))
+      {
+         const unsigned char c = static_cast<unsigned char>(pszData[i]);
+         if (IsUnreserved(c))
+            break;
+
+         szEscaped[usEscaped++] = '%';
+         szEscaped[usEscaped++] = s_szHex[c >> 4];
+         szEscaped[usEscaped++] = s_szHex[c & 0x0F];
+         ++i;
+      }
+      strOutput.append(szEscaped, usEscaped);
+   }
+}
+
+/**
+ * @brief case-insensitive prefix check, without copying the string
+ *
+ * @param [in] str string to check
+ * @param [in] pszPrefix prefix
+ *
+ * @retval true   str starts with pszPrefix (case-insensitive).
+ * @retval false  str doesn't start with pszPrefix.
+ */
+const bool CHTTPUrlBuilder::StartsWithNoCase(const std::string& str, const char* pszPrefix)
+{
+   const size_t usPrefixLength = std::strlen(pszPrefix);
+   if (str.size() < usPrefixLength)
+      return false;
+
+   for (size_t i = 0; i < usPrefixLength; ++i)
+   {
+      char c = str[i];
+      if (c >= 'A' && c <= 'Z')
+         c = static_cast<char>(c - 'A' + 'a');
+
+      char p = pszPrefix[i];
+      if (p >= 'A' && p <= 'Z')
+         p = static_cast<char>(p - 'A' + 'a');
+
+      if (c != p)
+         return false;
+   }
+
+   return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * @file HTTPUrlBuilder.h
+ * @brief URL and query string builder working in a reusable buffer
+ *
+ * @author Mohamed Amine Mzoughi <mohamed-amine.mzoughi@laposte.net>
+ */
+
+#ifndef INCLUDE_HTTPURLBUILDER_H_
+#define INCLUDE_HTTPURLBUILDER_H_
+
+#include <cstddef>         // std::size_t
+#include <string>
+
+/* Builds a URL with a query string in a buffer that is kept between uses, so once it
+ * has grown to its working size, building a new URL doesn't allocate memory.
+ * Parameters are percent-encoded (RFC 3986) in a single pass.
+ *
+ * Example Usage:
+ * @code
+ *    CHTTPUrlBuilder Url;
+ *    Url.SetBase("http://httpbin.org/get").AddParam("q", "a b").AddParam("page", 2);
+ *    pRESTClient->Get(Url.GetUrl(), Headers, Response); // http://httpbin.org/get?q=a%20b&page=2
+ * @endcode */
+class CHTTPUrlBuilder
+{
+public:
+   CHTTPUrlBuilder();
+   explicit CHTTPUrlBuilder(const std::string& strBaseUrl);
+
+   // URL
+   CHTTPUrlBuilder& SetBase(const std::string& strBaseUrl);
+   CHTTPUrlBuilder& SetBase(const char* pszBaseUrl, const size_t usLength);
+
+   // Query parameters (key and value are percent-encoded)
+   CHTTPUrlBuilder& AddParam(const std::string& strKey, const std::string& strValue);
+   CHTTPUrlBuilder& AddParam(const char* pszKey, const size_t usKeyLength,
+                             const char* pszValue, const size_t usValueLength);
+   CHTTPUrlBuilder& AddParam(const std::string& strKey, const long long llValue);
+
+   inline const std::string& GetUrl() const { return m_strUrl; }
+   inline const char* c_str() const { return m_strUrl.c_str(); }
+   inline void Clear() { m_strUrl.clear(); m_bHasQuery = false; } // keeps the buffer
+
+   // Helpers
+   static void AppendEncoded(std::string& strOutput, const char* pszData, const size_t usLength);
+   static const bool StartsWithNoCase(const std::string& str, const char* pszPrefix);
+
+protected:
+   std::string m_strUrl;
+   bool        m_bHasQuery;
+};
+
+#endif
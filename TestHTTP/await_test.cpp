@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"   // Google Test Framework
+#include "test_utils.h"    // Helpers for tests
+
+// Test subject (SUT), requires C++20 (see test_httpclient_await in CMakeLists.txt)
+#include "HTTPAwaitable.h"
+
+#define PRINT_LOG [](const std::string& strLogMsg) { std::cout << strLogMsg << std::endl;  }
+
+namespace
+{
+// minimal eagerly started coroutine type, enough to co_await requests in a test
+struct TestTask
+{
+   struct promise_type
+   {
+      TestTask get_return_object() { return {}; }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+   };
+};
+}
+
+TEST(HTTPAwaitClient, TestAwaitRequests)
+{
+   CHTTPTransferEngine Engine(PRINT_LOG);
+   ASSERT_TRUE(Engine.InitEngine());
+
+   CHTTPAwaitClient AwaitClient(Engine);
+   int iGetCode = 0;
+   int iPostCode = 0;
+
+   auto Coroutine = [&]() -> TestTask
+   {
+      CHTTPClient::HttpResponse Response = co_await AwaitClient.GetAwait("http://httpbin.org/get", {});
+      iGetCode = Response.iCode;
+
+      Response = co_await AwaitClient.PostAwait("http://httpbin.org/post", {}, "data");
+      iPostCode = Response.iCode;
+   };
+   Coroutine();
+
+   Engine.RunAll();
+
+   EXPECT_EQ(200, iGetCode);
+   EXPECT_EQ(200, iPostCode);
+
+   EXPECT_TRUE(Engine.CleanupEngine());
+}
+
+#ifdef LINUX
+TEST(HTTPAwaitClient, TestAwaitLocalRequests)
+{
+   CLocalHTTPServer Server;
+   ASSERT_TRUE(Server.StartTCP());
+   const std::string strUrl = "http://127.0.0.1:" + std::to_string(Server.GetPort()) + "/";
+
+   CHTTPTransferEngine Engine([](const std::string&) {});
+   ASSERT_TRUE(Engine.InitEngine());
+
+   CHTTPAwaitClient AwaitClient(Engine);
+   std::vector<CHTTPClient::HttpResponse> vecResponses;
+   bool bDone = false;
+
+   // each request is sent once the previous one is done, the coroutine resumes from RunAll
+   auto Coroutine = [&]() -> TestTask
+   {
+      vecResponses.push_back(co_await AwaitClient.GetAwait(strUrl, {}));
+      vecResponses.push_back(co_await AwaitClient.HeadAwait(strUrl, {}));
+      vecResponses.push_back(co_await AwaitClient.PostAwait(strUrl, {}, "data"));
+      vecResponses.push_back(co_await AwaitClient.PutAwait(strUrl, {}, "data"));
+      vecResponses.push_back(co_await AwaitClient.DelAwait(strUrl, {}));
+      bDone = true;
+   };
+   Coroutine();
+   EXPECT_TRUE(vecResponses.empty());
+
+   Engine.RunAll();
+
+   ASSERT_TRUE(bDone);
+   ASSERT_EQ(5u, vecResponses.size());
+   for (const CHTTPClient::HttpResponse& Response : vecResponses)
+      EXPECT_EQ(200, Response.iCode);
+   EXPECT_EQ("xx", vecResponses[0].strBody);
+   EXPECT_TRUE(vecResponses[1].strBody.empty());
+
+   // the engine's clients keep their connection
+   EXPECT_EQ(1u, Server.GetConnections());
+
+   EXPECT_TRUE(Engine.CleanupEngine());
+}
+#endif
+
+TEST(HTTPAwaitClient, TestAwaitSubmitFailure)
+{
+   // the engine isn't initialized : the request isn't submitted, the coroutine isn't suspended
+   CHTTPTransferEngine Engine([](const std::string&) {});
+   CHTTPAwaitClient AwaitClient(Engine);
+
+   int iCode = 0;
+   auto Coroutine = [&]() -> TestTask
+   {
+      CHTTPClient::HttpResponse Response = co_await AwaitClient.GetAwait("http://127.0.0.1:1/", {});
+      iCode = Response.iCode;
+   };
+   Coroutine();
+
+   EXPECT_EQ(-1, iCode);
+}
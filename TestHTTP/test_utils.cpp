@@ -1,5 +1,20 @@
 #include "test_utils.h"
 
+#ifdef LINUX
+#include <arpa/inet.h>
+#include <cstddef>         // offsetof
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#if defined(LINUX) && defined(HTTPCLIENT_OPENSSL)
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#endif
+
 // Test configuration constants (to be loaded from an INI file)
 bool HTTP_PROXY_TEST_ENABLED;
 
@@ -185,3 +200,345 @@ bool AreFilesEqual(const std::string& strlFilePath, const std::string& strrFileP
    return true;
 }
 #endif
+
+#ifdef LINUX
+CLocalHTTPServer::CLocalHTTPServer(const size_t usBodySize /* = 2 */) :
+   m_strBody(usBodySize, 'x'),
+   m_iListenFd(-1),
+   m_iPort(0),
+   m_bStopping(false),
+   m_usConnections(0)
+#ifdef HTTPCLIENT_OPENSSL
+   , m_pSslCtx(nullptr),
+   m_usResumedSessions(0)
+#endif
+{
+}
+
+CLocalHTTPServer::~CLocalHTTPServer()
+{
+   Stop();
+
+#ifdef HTTPCLIENT_OPENSSL
+   SSL_CTX_free(m_pSslCtx);
+#endif
+}
+
+bool CLocalHTTPServer::StartTCP()
+{
+   const int iFd = socket(AF_INET, SOCK_STREAM, 0);
+
+   sockaddr_in Address;
+   memset(&Address, 0, sizeof(Address));
+   Address.sin_family = AF_INET;
+   Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   Address.sin_port = 0;
+
+   socklen_t iLength = sizeof(Address);
+   if (iFd < 0 || bind(iFd, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0
+       || getsockname(iFd, reinterpret_cast<sockaddr*>(&Address), &iLength) != 0)
+   {
+      if (iFd >= 0)
+         close(iFd);
+      return false;
+   }
+
+   m_iPort = ntohs(Address.sin_port);
+   return Listen(iFd);
+}
+
+bool CLocalHTTPServer::StartUnix(const std::string& strPath, const bool bAbstract /* = false */)
+{
+   sockaddr_un Address;
+   memset(&Address, 0, sizeof(Address));
+   Address.sun_family = AF_UNIX;
+   if (strPath.size() + 1 >= sizeof(Address.sun_path))
+      return false;
+
+   // an abstract name starts with a null byte and isn't terminated
+   const size_t usOffset = (bAbstract) ? 1 : 0;
+   memcpy(Address.sun_path + usOffset, strPath.c_str(), strPath.size());
+   const socklen_t iLength = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + usOffset + strPath.size()
+                                                    + ((bAbstract) ? 0 : 1));
+   if (!bAbstract)
+      unlink(strPath.c_str());
+
+   const int iFd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (iFd < 0 || bind(iFd, reinterpret_cast<sockaddr*>(&Address), iLength) != 0)
+   {
+      if (iFd >= 0)
+         close(iFd);
+      return false;
+   }
+
+   return Listen(iFd);
+}
+
+#ifdef HTTPCLIENT_OPENSSL
+bool CLocalHTTPServer::StartTLS(const std::string& strCertFile, const std::string& strKeyFile,
+                                const bool bRequestClientCert /* = false */)
+{
+   SSL_CTX_free(m_pSslCtx);
+   m_pSslCtx = SSL_CTX_new(TLS_server_method());
+   if (m_pSslCtx == nullptr
+       || SSL_CTX_use_certificate_chain_file(m_pSslCtx, strCertFile.c_str()) != 1
+       || SSL_CTX_use_PrivateKey_file(m_pSslCtx, strKeyFile.c_str(), SSL_FILETYPE_PEM) != 1)
+      return false;
+
+   // any certificate is accepted, the client only has to send one
+   if (bRequestClientCert)
+      SSL_CTX_set_verify(m_pSslCtx, SSL_VERIFY_PEER, [](int, X509_STORE_CTX*) { return 1; });
+
+   // the sessions resumed with a TLS 1.2 session id are looked up by the context's id
+   static const unsigned char CONTEXT_ID[] = "CLocalHTTPServer";
+   SSL_CTX_set_session_id_context(m_pSslCtx, CONTEXT_ID, sizeof(CONTEXT_ID) - 1);
+
+   return StartTCP();
+}
+#endif
+
+void CLocalHTTPServer::Stop()
+{
+   m_bStopping = true;
+
+   if (m_AcceptThread.joinable())
+      m_AcceptThread.join();
+
+   std::vector<std::thread> vecClients;
+   {
+      std::lock_guard<std::mutex> Lock(m_mtxClients);
+      vecClients.swap(m_vecClients);
+   }
+   for (std::thread& Client : vecClients)
+      Client.join();
+
+   if (m_iListenFd >= 0)
+   {
+      close(m_iListenFd);
+      m_iListenFd = -1;
+   }
+}
+
+std::string CLocalHTTPServer::GetLastRequestLine()
+{
+   std::lock_guard<std::mutex> Lock(m_mtxClients);
+   return m_strLastRequestLine;
+}
+
+bool CLocalHTTPServer::Listen(const int iListenFd)
+{
+   if (listen(iListenFd, 128) != 0)
+   {
+      close(iListenFd);
+      return false;
+   }
+
+   m_iListenFd = iListenFd;
+   m_bStopping = false;
+   m_AcceptThread = std::thread(&CLocalHTTPServer::AcceptLoop, this);
+   return true;
+}
+
+void CLocalHTTPServer::AcceptLoop()
+{
+   while (!m_bStopping)
+   {
+      pollfd ListenPoll = { m_iListenFd, POLLIN, 0 };
+      if (poll(&ListenPoll, 1, 50) <= 0)
+         continue;
+
+      const int iFd = accept(m_iListenFd, nullptr, nullptr);
+      if (iFd < 0)
+         continue;
+
+      ++m_usConnections;
+      std::lock_guard<std::mutex> Lock(m_mtxClients);
+      m_vecClients.emplace_back(&CLocalHTTPServer::Serve, this, iFd);
+   }
+}
+
+void CLocalHTTPServer::Serve(const int iFd)
+{
+   std::string strRequests;
+   char szBuffer[16384];
+   bool bContinued = false;   // "100 Continue" sent for the pending request
+
+#ifdef HTTPCLIENT_OPENSSL
+   SSL* pSsl = nullptr;
+   if (m_pSslCtx)
+   {
+      pSsl = SSL_new(m_pSslCtx);
+      SSL_set_fd(pSsl, iFd);
+      if (SSL_accept(pSsl) != 1)
+      {
+         SSL_free(pSsl);
+         close(iFd);
+         return;
+      }
+      if (SSL_session_reused(pSsl))
+         ++m_usResumedSessions;
+   }
+
+   const auto Receive = [pSsl](const int iSocket, char* pBuffer, const size_t usSize) -> ssize_t
+   {
+      return (pSsl) ? SSL_read(pSsl, pBuffer, static_cast<int>(usSize)) : recv(iSocket, pBuffer, usSize, 0);
+   };
+   const auto Send = [pSsl](const int iSocket, const char* pData, const size_t usSize) -> ssize_t
+   {
+      return (pSsl) ? SSL_write(pSsl, pData, static_cast<int>(usSize)) : send(iSocket, pData, usSize, MSG_NOSIGNAL);
+   };
+   const auto Close = [pSsl](const int iSocket)
+   {
+      SSL_free(pSsl);
+      close(iSocket);
+   };
+#else
+   const auto Receive = [](const int iSocket, char* pBuffer, const size_t usSize) -> ssize_t
+   {
+      return recv(iSocket, pBuffer, usSize, 0);
+   };
+   const auto Send = [](const int iSocket, const char* pData, const size_t usSize) -> ssize_t
+   {
+      return send(iSocket, pData, usSize, MSG_NOSIGNAL);
+   };
+   const auto Close = [](const int iSocket) { close(iSocket); };
+#endif
+
+   while (!m_bStopping)
+   {
+#ifdef HTTPCLIENT_OPENSSL
+      // decrypted data may be waiting in the SSL object, the socket won't signal it
+      if (!pSsl || SSL_pending(pSsl) == 0)
+#endif
+      {
+         pollfd ClientPoll = { iFd, POLLIN, 0 };
+         if (poll(&ClientPoll, 1, 50) <= 0)
+            continue;
+      }
+
+      const ssize_t iRead = Receive(iFd, szBuffer, sizeof(szBuffer));
+      if (iRead <= 0)
+         break;
+      strRequests.append(szBuffer, static_cast<size_t>(iRead));
+
+      // answers the complete requests (headers and body) received so far
+      size_t usHeadersEnd;
+      while ((usHeadersEnd = strRequests.find("\r\n\r\n")) != std::string::npos)
+      {
+         size_t usBodyLength = 0;
+         const size_t usLengthPos = strRequests.find("Content-Length:");
+         if (usLengthPos != std::string::npos && usLengthPos < usHeadersEnd)
+            usBodyLength = std::strtoul(strRequests.c_str() + usLengthPos + 15, nullptr, 10);
+
+         if (strRequests.size() < usHeadersEnd + 4 + usBodyLength)
+         {
+            // libcurl waits for it before sending a large body
+            const size_t usExpectPos = strRequests.find("Expect: 100-continue");
+            if (!bContinued && usExpectPos != std::string::npos && usExpectPos < usHeadersEnd)
+            {
+               static const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+               bContinued = Send(iFd, CONTINUE, sizeof(CONTINUE) - 1) > 0;
+            }
+            break;
+         }
+
+         {
+            std::lock_guard<std::mutex> Lock(m_mtxClients);
+            m_strLastRequestLine = strRequests.substr(0, strRequests.find("\r\n"));
+         }
+
+         const bool bHead = strRequests.compare(0, 5, "HEAD ") == 0;
+         const bool bConnect = strRequests.compare(0, 8, "CONNECT ") == 0;
+         strRequests.erase(0, usHeadersEnd + 4 + usBodyLength);
+         bContinued = false;
+
+         // as a proxy : the tunnel leads to this server
+         if (bConnect)
+         {
+            static const char ESTABLISHED[] = "HTTP/1.1 200 Connection established\r\n\r\n";
+            if (Send(iFd, ESTABLISHED, sizeof(ESTABLISHED) - 1) <= 0)
+            {
+               Close(iFd);
+               return;
+            }
+            continue;
+         }
+
+         std::string strResponse = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: "
+                                 + std::to_string(m_strBody.size()) + "\r\n\r\n";
+         if (!bHead)
+            strResponse += m_strBody;
+
+         for (size_t usSent = 0; usSent < strResponse.size(); )
+         {
+            const ssize_t iSent = Send(iFd, strResponse.data() + usSent, strResponse.size() - usSent);
+            if (iSent <= 0)
+            {
+               Close(iFd);
+               return;
+            }
+            usSent += static_cast<size_t>(iSent);
+         }
+      }
+   }
+
+   Close(iFd);
+}
+
+#ifdef HTTPCLIENT_OPENSSL
+bool CreateSelfSignedCertificate(const std::string& strCertFile, const std::string& strKeyFile)
+{
+   // P-256 key (EVP_PKEY_Q_keygen needs OpenSSL 3)
+   EVP_PKEY* pKey = nullptr;
+   EVP_PKEY_CTX* pKeyCtx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+   if (pKeyCtx == nullptr || EVP_PKEY_keygen_init(pKeyCtx) != 1
+       || EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pKeyCtx, NID_X9_62_prime256v1) != 1
+       || EVP_PKEY_keygen(pKeyCtx, &pKey) != 1)
+   {
+      EVP_PKEY_CTX_free(pKeyCtx);
+      return false;
+   }
+   EVP_PKEY_CTX_free(pKeyCtx);
+
+   X509* pCert = X509_new();
+   X509_set_version(pCert, 2);
+   ASN1_INTEGER_set(X509_get_serialNumber(pCert), static_cast<long>(time(nullptr)));
+   X509_gmtime_adj(X509_getm_notBefore(pCert), -3600);
+   X509_gmtime_adj(X509_getm_notAfter(pCert), 24 * 3600);
+   X509_set_pubkey(pCert, pKey);
+
+   X509_NAME* pName = X509_get_subject_name(pCert);
+   X509_NAME_add_entry_by_txt(pName, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"),
+                              -1, -1, 0);
+   X509_set_issuer_name(pCert, pName);
+
+   X509V3_CTX ExtCtx;
+   X509V3_set_ctx_nodb(&ExtCtx);
+   X509V3_set_ctx(&ExtCtx, pCert, pCert, nullptr, nullptr, 0);
+   bool bSuccess = true;
+   for (const char* pszExt : { "subjectAltName=DNS:localhost,IP:127.0.0.1", "basicConstraints=critical,CA:TRUE" })
+   {
+      const std::string strExt(pszExt);
+      const size_t usEqual = strExt.find('=');
+      X509_EXTENSION* pExt = X509V3_EXT_conf(nullptr, &ExtCtx, strExt.substr(0, usEqual).c_str(),
+                                             strExt.substr(usEqual + 1).c_str());
+      bSuccess = bSuccess && pExt && X509_add_ext(pCert, pExt, -1) == 1;
+      X509_EXTENSION_free(pExt);
+   }
+   bSuccess = bSuccess && X509_sign(pCert, pKey, EVP_sha256()) > 0;
+
+   FILE* pCertFile = (bSuccess) ? fopen(strCertFile.c_str(), "w") : nullptr;
+   FILE* pKeyFile = (bSuccess) ? fopen(strKeyFile.c_str(), "w") : nullptr;
+   bSuccess = pCertFile && pKeyFile && PEM_write_X509(pCertFile, pCert) == 1
+              && PEM_write_PrivateKey(pKeyFile, pKey, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+   if (pCertFile)
+      fclose(pCertFile);
+   if (pKeyFile)
+      fclose(pKeyFile);
+
+   X509_free(pCert);
+   EVP_PKEY_free(pKey);
+   return bSuccess;
+}
+#endif
+#endif
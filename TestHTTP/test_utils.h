@@ -20,6 +20,18 @@
 #include <thread>
 #include <vector>
 
+#ifdef LINUX
+#include <atomic>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+#if defined(LINUX) && defined(HTTPCLIENT_OPENSSL)
+#include <openssl/ssl.h>
+#endif
+
 #ifdef WINDOWS
 #ifdef _DEBUG
 #ifdef _USE_VLD_
@@ -52,6 +64,56 @@ bool GetFileTime(const char* const & pszFilePath, time_t& tLastModificationTime)
 
 bool AreFilesEqual(const std::string& strlFilePath, const std::string& strrFilePath);
 
+#ifdef LINUX
+/* minimal HTTP/1.1 server (keep-alive) answering every request with a fixed body, listening
+ * on 127.0.0.1 or on a Unix domain socket : stand-in for the tests needing a local peer */
+class CLocalHTTPServer
+{
+public:
+   explicit CLocalHTTPServer(const size_t usBodySize = 2);
+   ~CLocalHTTPServer();
+
+   bool StartTCP();                   // on an ephemeral port, see GetPort()
+   bool StartUnix(const std::string& strPath, const bool bAbstract = false);
+#ifdef HTTPCLIENT_OPENSSL
+   /* HTTPS on an ephemeral port, the clients' certificates are requested (but not verified)
+    * if bRequestClientCert */
+   bool StartTLS(const std::string& strCertFile, const std::string& strKeyFile,
+                 const bool bRequestClientCert = false);
+   size_t GetResumedSessions() const { return m_usResumedSessions; }
+#endif
+   void Stop();
+
+   int GetPort() const { return m_iPort; }
+   size_t GetConnections() const { return m_usConnections; }
+   std::string GetLastRequestLine();  // e.g. "GET http://host/ HTTP/1.1" when used as a proxy
+
+private:
+   bool Listen(const int iListenFd);
+   void AcceptLoop();
+   void Serve(const int iFd);
+
+   std::string              m_strBody;
+   int                      m_iListenFd;
+   int                      m_iPort;
+   std::atomic<bool>        m_bStopping;
+   std::atomic<size_t>      m_usConnections;
+   std::thread              m_AcceptThread;
+   std::mutex               m_mtxClients;
+   std::string              m_strLastRequestLine;
+   std::vector<std::thread> m_vecClients;
+#ifdef HTTPCLIENT_OPENSSL
+   SSL_CTX*                 m_pSslCtx;
+   std::atomic<size_t>      m_usResumedSessions;
+#endif
+};
+
+#ifdef HTTPCLIENT_OPENSSL
+// writes a self-signed certificate for localhost and 127.0.0.1 and its key (PEM files)
+bool CreateSelfSignedCertificate(const std::string& strCertFile, const std::string& strKeyFile);
+#endif
+#endif
+
 //}
 
 #endif